@@ -0,0 +1,69 @@
+#include <chrono>
+#include <cstdio>
+#include <db/Database.hpp>
+#include <db/HeapFile.hpp>
+#include <thread>
+
+// Stress test of the BufferPool: every thread inserts into and then repeatedly scans its own HeapFile.
+// Reports the tuple throughput for a growing number of threads with a single latch and with a sharded pool.
+
+constexpr size_t num_tuples = 20'000;
+constexpr size_t num_scans = 10;
+
+static void worker(const std::string &name) {
+    db::DbFile &file = db::getDatabase().get(name);
+    for (size_t i = 0; i < num_tuples; i++) {
+        file.insertTuple({{static_cast<int>(i), 0.5}});
+    }
+    size_t count = 0;
+    for (size_t scan = 0; scan < num_scans; scan++) {
+        for (auto it = file.begin(); it != file.end(); ++it) {
+            count++;
+        }
+    }
+    if (count != num_tuples * num_scans) {
+        std::fprintf(stderr, "%s: scanned %zu tuples\n", name.c_str(), count);
+    }
+}
+
+static double throughput(size_t num_threads, size_t num_shards) {
+    db::Database &db = db::getDatabase();
+    // Smaller than the files of many threads, so that the threads also evict each other's pages
+    db.configureBufferPool({1024, db::huge_pages_t::NONE, db::replacement_t::CLOCK, num_shards});
+    db::TupleDesc td({db::type_t::INT, db::type_t::DOUBLE}, {"id", "value"});
+
+    std::vector<std::string> names;
+    for (size_t i = 0; i < num_threads; i++) {
+        names.push_back("concurrency_bench_" + std::to_string(i) + ".dat");
+        std::remove(names.back().c_str());
+        db.add(std::make_unique<db::HeapFile>(names.back(), td));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (const std::string &name: names) {
+        threads.emplace_back(worker, name);
+    }
+    for (std::thread &thread: threads) {
+        thread.join();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    for (const std::string &name: names) {
+        db.remove(name);
+        std::remove(name.c_str());
+    }
+    return static_cast<double>(num_threads * num_tuples * (num_scans + 1)) / elapsed.count();
+}
+
+int main(int argc, char *argv[]) {
+    // The maximum number of threads defaults to the number of cores
+    size_t max_threads = argc > 1 ? std::stoul(argv[1]) : std::max(1u, std::thread::hardware_concurrency());
+    std::printf("%10s %16s %16s\n", "threads", "1 shard tup/s", "64 shards tup/s");
+    for (size_t num_threads = 1; num_threads <= max_threads; num_threads *= 2) {
+        double single = throughput(num_threads, 1);
+        double sharded = throughput(num_threads, 64);
+        std::printf("%10zu %16.0f %16.0f\n", num_threads, single, sharded);
+    }
+    return 0;
+}
@@ -0,0 +1,50 @@
+#include <chrono>
+#include <cstdio>
+#include <db/Database.hpp>
+#include <db/HeapFile.hpp>
+
+// Bulk load of a HeapFile: tuples inserted one at a time, a page at a time through the buffer pool, and appended with
+// pages built outside of the pool.
+
+constexpr size_t num_tuples = 1'000'000;
+
+template<typename F>
+static double throughput(const std::vector<db::Tuple> &tuples, F &&load) {
+    db::Database &db = db::getDatabase();
+    db::TupleDesc td({db::type_t::INT, db::type_t::DOUBLE}, {"id", "value"});
+    const std::string name{"insert_bench.dat"};
+    std::remove(name.c_str());
+    std::remove((name + ".fsm").c_str());
+    db.add(std::make_unique<db::HeapFile>(name, td));
+    auto &file = dynamic_cast<db::HeapFile &>(db.get(name));
+    auto start = std::chrono::steady_clock::now();
+    load(file, tuples);
+    db.getBufferPool().flushFile(name);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    db.remove(name);
+    std::remove(name.c_str());
+    std::remove((name + ".fsm").c_str());
+    return static_cast<double>(tuples.size()) / elapsed.count();
+}
+
+int main() {
+    std::vector<db::Tuple> tuples;
+    tuples.reserve(num_tuples);
+    for (size_t i = 0; i < num_tuples; i++) {
+        tuples.push_back({{static_cast<int>(i), 0.5}});
+    }
+    double single = throughput(tuples, [](db::HeapFile &file, const std::vector<db::Tuple> &tuples) {
+        for (const db::Tuple &t: tuples) {
+            file.insertTuple(t);
+        }
+    });
+    double paged = throughput(tuples, [](db::HeapFile &file, const std::vector<db::Tuple> &tuples) {
+        file.insertTuples(tuples);
+    });
+    double appended = throughput(tuples, [](db::HeapFile &file, const std::vector<db::Tuple> &tuples) {
+        file.appendTuples(tuples);
+    });
+    std::printf("%16s %16s %16s\n", "insertTuple/s", "insertTuples/s", "appendTuples/s");
+    std::printf("%16.0f %16.0f %16.0f\n", single, paged, appended);
+    return 0;
+}
@@ -0,0 +1,117 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <db/BTreeFile.hpp>
+#include <db/Database.hpp>
+#include <db/HeapFile.hpp>
+#include <db/IndexPage.hpp>
+#include <db/LeafPage.hpp>
+#include <random>
+
+// Scan and lookup cost at the page size of this build. The page size is a compile-time constant, so CMake builds one
+// executable per size (page_size_bench_<bytes>, see DB_BENCH_PAGE_SIZES); run them side by side to compare.
+// The buffer pool has the same size in bytes for every page size and holds the whole data set.
+
+constexpr size_t num_tuples = 500'000;
+constexpr size_t num_scans = 5;
+constexpr size_t num_lookups = 1'000'000;
+constexpr size_t pool_bytes = 64 << 20;
+
+template<typename F>
+static double seconds(F &&f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+static size_t scan(const db::DbFile &file) {
+    size_t count = 0;
+    for (auto it = file.begin(); it != file.end(); ++it) {
+        count++;
+    }
+    return count;
+}
+
+// Root-to-leaf descent followed by a binary search of the leaf, as in BTreeFile::insertTuple
+static bool lookup(db::BufferPool &bufferPool, db::file_id_t file, const db::TupleDesc &td, int key) {
+    db::PageId pid{file, 0};
+    while (true) {
+        db::PageGuard guard = bufferPool.pin(pid);
+        db::IndexPage node(*guard);
+        pid.page = node.children[std::upper_bound(node.keys, node.keys + node.header->size, key) - node.keys];
+        if (!node.header->index_children) {
+            break;
+        }
+    }
+    db::PageGuard guard = bufferPool.pin(pid);
+    db::LeafPage leaf(*guard, td, 0);
+    size_t width = td.length();
+    size_t lo = 0, hi = leaf.header->size;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (*reinterpret_cast<const int *>(leaf.data + mid * width) < key) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo < leaf.header->size && *reinterpret_cast<const int *>(leaf.data + lo * width) == key;
+}
+
+int main() {
+    db::Database &db = db::getDatabase();
+    db.configureBufferPool({pool_bytes / db::DEFAULT_PAGE_SIZE});
+    db::TupleDesc td({db::type_t::INT, db::type_t::DOUBLE}, {"id", "value"});
+
+    const std::string heap_name{"page_size_bench.heap"};
+    const std::string tree_name{"page_size_bench.btree"};
+    std::remove(heap_name.c_str());
+    std::remove(tree_name.c_str());
+    db.add(std::make_unique<db::HeapFile>(heap_name, td));
+    db.add(std::make_unique<db::BTreeFile>(tree_name, td, 0));
+    db::DbFile &heap = db.get(heap_name);
+    db::DbFile &tree = db.get(tree_name);
+
+    std::vector<int> keys(num_tuples);
+    for (size_t i = 0; i < num_tuples; i++) {
+        keys[i] = static_cast<int>(i);
+    }
+    std::shuffle(keys.begin(), keys.end(), std::mt19937(42));
+    for (int key: keys) {
+        heap.insertTuple({{key, 0.5}});
+        tree.insertTuple({{key, 0.5}});
+    }
+
+    size_t scanned = 0;
+    double scan_time = seconds([&] {
+        for (size_t i = 0; i < num_scans; i++) {
+            scanned += scan(heap);
+        }
+    });
+
+    db::BufferPool &bufferPool = db.getBufferPool();
+    db::file_id_t file = db.getFileId(tree_name);
+    std::mt19937 gen(7);
+    std::uniform_int_distribution<int> dist(0, num_tuples - 1);
+    size_t found = 0;
+    double lookup_time = seconds([&] {
+        for (size_t i = 0; i < num_lookups; i++) {
+            found += lookup(bufferPool, file, td, dist(gen));
+        }
+    });
+    if (scanned != num_tuples * num_scans || found != num_lookups) {
+        std::fprintf(stderr, "scanned %zu tuples, found %zu keys\n", scanned, found);
+    }
+
+    std::printf("%10s %12s %12s %16s %16s\n", "page size", "pool pages", "index cap", "scan tup/s", "lookups/s");
+    std::printf("%10zu %12zu %12u %16.0f %16.0f\n", db::DEFAULT_PAGE_SIZE, bufferPool.size(),
+                static_cast<unsigned>(db::IndexPage::capacity), static_cast<double>(scanned) / scan_time,
+                static_cast<double>(num_lookups) / lookup_time);
+
+    db.remove(heap_name);
+    db.remove(tree_name);
+    std::remove(heap_name.c_str());
+    std::remove(tree_name.c_str());
+    return 0;
+}
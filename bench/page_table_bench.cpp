@@ -0,0 +1,98 @@
+#include <chrono>
+#include <cstdio>
+#include <db/Database.hpp>
+#include <db/DbFile.hpp>
+#include <db/Replacer.hpp>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <unordered_map>
+
+// Contention benchmark of the page table: every thread pins and unpins resident pages of the same shard, so all
+// lookups probe one table. Compares BufferPool::pin hits with the previous hit path (a std::unordered_map lookup and an
+// LRU update under the shard latch) for a growing number of threads.
+
+constexpr size_t num_pages = 4096;
+constexpr size_t lookups_per_thread = 1'000'000;
+
+static std::vector<size_t> makeTrace(size_t seed) {
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<size_t> dist(0, num_pages - 1);
+    std::vector<size_t> trace(4096);
+    for (size_t &page: trace) {
+        page = dist(gen);
+    }
+    return trace;
+}
+
+template<typename F>
+static double run(size_t num_threads, F &&lookup) {
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t t = 0; t < num_threads; t++) {
+        threads.emplace_back([&lookup, t] {
+            std::vector<size_t> trace = makeTrace(t);
+            for (size_t i = 0; i < lookups_per_thread; i++) {
+                lookup(trace[i % trace.size()]);
+            }
+        });
+    }
+    for (std::thread &thread: threads) {
+        thread.join();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return static_cast<double>(num_threads * lookups_per_thread) / elapsed.count();
+}
+
+static double poolThroughput(size_t num_threads) {
+    db::Database &db = db::getDatabase();
+    db.configureBufferPool({num_pages});
+    db::BufferPool &bufferPool = db.getBufferPool();
+    const std::string name{"page_table_bench.dat"};
+    std::remove(name.c_str());
+    db.add(std::make_unique<db::DbFile>(name, db::TupleDesc()));
+    db::file_id_t file = db.getFileId(name);
+    for (size_t i = 0; i < num_pages; i++) {
+        bufferPool.getPage({file, i});
+    }
+    double throughput = run(num_threads, [&bufferPool, file](size_t page) { bufferPool.pin({file, page}); });
+    db.remove(name);
+    std::remove(name.c_str());
+    return throughput;
+}
+
+static double latchedThroughput(size_t num_threads) {
+    std::mutex latch;
+    std::unordered_map<const db::PageId, size_t> table;
+    for (size_t i = 0; i < num_pages; i++) {
+        table[{0, i}] = i;
+    }
+    db::LruReplacer replacer;
+    for (size_t i = 0; i < num_pages; i++) {
+        replacer.insert(i, {0, i});
+    }
+    std::vector<uint32_t> pins(num_pages);
+    return run(num_threads, [&](size_t page) {
+        size_t pos;
+        {
+            std::lock_guard lock(latch);
+            pos = table.at({0, page});
+            replacer.touch(pos);
+            pins[pos]++;
+        }
+        std::lock_guard lock(latch);
+        pins[pos]--;
+    });
+}
+
+int main(int argc, char *argv[]) {
+    // The maximum number of threads defaults to the number of cores
+    size_t max_threads = argc > 1 ? std::stoul(argv[1]) : std::max(1u, std::thread::hardware_concurrency());
+    std::printf("%10s %16s %16s\n", "threads", "pool pins/s", "latched pins/s");
+    for (size_t num_threads = 1; num_threads <= max_threads; num_threads *= 2) {
+        double pool = poolThroughput(num_threads);
+        double latched = latchedThroughput(num_threads);
+        std::printf("%10zu %16.0f %16.0f\n", num_threads, pool, latched);
+    }
+    return 0;
+}
@@ -0,0 +1,54 @@
+#include <chrono>
+#include <cstdio>
+#include <db/Database.hpp>
+#include <db/DbFile.hpp>
+#include <random>
+
+// Measures the latency of BufferPool::getPage hits (every page is resident) for each replacement policy.
+
+static double hitLatency(db::replacement_t policy, size_t num_pages, size_t iterations) {
+    db::Database &db = db::getDatabase();
+    db.configureBufferPool({num_pages, db::huge_pages_t::NONE, policy});
+    db::BufferPool &bufferPool = db.getBufferPool();
+
+    const std::string name{"replacer_bench.dat"};
+    std::remove(name.c_str());
+    db.add(std::make_unique<db::DbFile>(name, db::TupleDesc()));
+
+    for (size_t i = 0; i < num_pages; i++) {
+        bufferPool.getPage({name, i});
+    }
+    std::mt19937 gen(660);
+    std::uniform_int_distribution<size_t> dist(0, num_pages - 1);
+    std::vector<db::PageId> trace;
+    trace.reserve(4096);
+    for (size_t i = 0; i < 4096; i++) {
+        trace.push_back({name, dist(gen)});
+    }
+
+    uintptr_t sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; i++) {
+        sink += reinterpret_cast<uintptr_t>(&bufferPool.getPage(trace[i % trace.size()]));
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    if (sink == 0) {
+        std::puts("");
+    }
+
+    db.remove(name);
+    std::remove(name.c_str());
+    return std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+}
+
+int main() {
+    constexpr size_t iterations = 5'000'000;
+    std::printf("%10s %10s %10s %10s\n", "frames", "LRU ns", "CLOCK ns", "2Q ns");
+    for (size_t num_pages: {64, 1024, 16384}) {
+        double lru = hitLatency(db::replacement_t::LRU, num_pages, iterations);
+        double clock = hitLatency(db::replacement_t::CLOCK, num_pages, iterations);
+        double two_q = hitLatency(db::replacement_t::TWO_Q, num_pages, iterations);
+        std::printf("%10zu %10.1f %10.1f %10.1f\n", num_pages, lru, clock, two_q);
+    }
+    return 0;
+}
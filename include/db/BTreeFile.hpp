@@ -14,8 +14,9 @@ public:
    * @brief Initialize a BTreeFile
    *
    * @param key_index the index of the key in the tuple
+   * @param options how the file is opened
    */
-  BTreeFile(const std::string &name, const TupleDesc &td, size_t key_index);
+  BTreeFile(const std::string &name, const TupleDesc &td, size_t key_index, const DbFileOptions &options = {});
 
   /**
    * @brief Insert a tuple into the file
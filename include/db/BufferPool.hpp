@@ -1,30 +1,343 @@
 #pragma once
 
+#include <db/IoBackend.hpp>
+#include <db/Metrics.hpp>
+#include <db/PageTable.hpp>
+#include <db/Replacer.hpp>
 #include <db/types.hpp>
-#include <list>
-#include <unordered_map>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <span>
+#include <thread>
 #include <unordered_set>
 #include <vector>
 
 namespace db {
     constexpr size_t DEFAULT_NUM_PAGES = 50;
 
+    /// Initial read-ahead window of a sequential stream
+    constexpr size_t READAHEAD_MIN_PAGES = 4;
+
+    /// Number of concurrent sequential streams tracked per file (files that share a stream set share its streams)
+    constexpr size_t READAHEAD_STREAMS = 4;
+
+    /// Number of stream sets, each with its own latch: a file uses the set of its file id modulo this number
+    constexpr size_t READAHEAD_STREAM_SETS = 64;
+
+    /// Number of frames a large sequential scan recycles instead of going through the replacement policy
+    constexpr size_t SCAN_RING_PAGES = 16;
+
+    /// Size of an explicit (hugetlbfs) or transparent huge page used to round the frame arena.
+    constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+    /**
+     * @brief How the frame arena of a BufferPool is backed.
+     * @details NONE uses regular pages, TRANSPARENT asks the kernel to back the arena with transparent huge pages, and
+     * EXPLICIT maps the arena with MAP_HUGETLB (falling back to TRANSPARENT if no huge pages are reserved).
+     */
+    enum class huge_pages_t {
+        NONE, TRANSPARENT, EXPLICIT
+    };
+
+    /**
+     * @brief Options used to construct a BufferPool.
+     */
+    struct BufferPoolOptions {
+        /// The number of frames in the pool
+        size_t num_pages = DEFAULT_NUM_PAGES;
+
+        /// The backing of the frame arena
+        huge_pages_t huge_pages = huge_pages_t::NONE;
+
+        /// The policy used to choose the page to evict
+        replacement_t replacement = replacement_t::LRU;
+
+        /// The number of partitions of the pool, each with its own latch, frames and replacement state
+        size_t num_shards = 1;
+
+        /// Share of the frames (0 to 1) the background writer keeps clean; 0 disables the background writer
+        double clean_target = 0;
+
+        /// Maximum number of pages per second written by the background writer; 0 disables the background writer
+        size_t writer_pages_per_second = 1000;
+
+        /// How often the background writer wakes up
+        std::chrono::milliseconds writer_interval{10};
+
+        /// Largest read-ahead window of a sequential stream; 0 disables read-ahead
+        size_t readahead_max_pages = 0;
+
+        /// The backend used for batched flushes and read-ahead (SYNC if io_uring is not available)
+        io_backend_t io_backend = io_backend_t::SYNC;
+
+        /// The number of requests in a batch submitted to the I/O backend
+        unsigned io_queue_depth = 64;
+
+        /// The number of frames of the ring used by scans of files larger than the pool; 0 disables scan rings
+        size_t scan_ring_pages = SCAN_RING_PAGES;
+    };
+
+    /**
+     * @brief Counters of the page accesses served by a BufferPool.
+     */
+    struct BufferPoolStats {
+        /// The number of getPage calls served from memory
+        size_t hits = 0;
+
+        /// The number of getPage calls that read the page from disk
+        size_t misses = 0;
+
+        /// The number of pages evicted to make room for another page
+        size_t evictions = 0;
+
+        /// The number of dirty pages written by the background writer
+        size_t background_writes = 0;
+
+        /// The number of pages read ahead of a sequential stream
+        size_t prefetches = 0;
+
+        /// The number of dirty pages written back to disk (by evictions, flushes and the background writer)
+        size_t writebacks = 0;
+
+        /// The number of frames a scan ring released to read its next page
+        size_t recycled = 0;
+
+        /// Time to serve a getPage call that read the page from disk, including the eviction of a victim
+        LatencyHistogram miss_latency;
+
+        /**
+         * @brief: Returns the fraction of getPage calls served from memory (0 if there were none).
+         */
+        double hitRatio() const;
+    };
+
+    /**
+     * @brief The latch a PageGuard holds on the contents of its frame.
+     * @details NONE only pins the frame. SHARED and EXCLUSIVE also hold a reader or writer latch on the frame.
+     */
+    enum class latch_t {
+        NONE, SHARED, EXCLUSIVE
+    };
+
+    class BufferPool;
+
+/**
+ * @brief The frames borrowed by a sequential scan (a "bulk read" access strategy).
+ * @details A page read through a ring is remembered in one of its slots. When the ring wraps around, the page in the
+ * slot is dropped from the pool (written first if dirty) to make room for the next one, so a large scan only occupies
+ * a few frames instead of evicting the rest of the pool. Pages that were already resident are not part of the ring.
+ * @note A BufferRing is used by a single scan and is not thread-safe.
+ */
+    class BufferRing {
+        std::vector<PageId> slots;
+        size_t next = 0;
+
+        friend class BufferPool;
+
+    public:
+        explicit BufferRing(size_t size) : slots(size) {}
+
+        size_t size() const { return slots.size(); }
+    };
+
+/**
+ * @brief A handle to a page pinned in the BufferPool.
+ * @details While a PageGuard is held the frame of the page cannot be evicted or discarded, so the page can be used
+ * across other BufferPool calls. The page is unpinned (and its latch released) when the guard is destroyed.
+ * @note A PageGuard is move-only.
+ */
+    class PageGuard {
+        BufferPool *pool = nullptr;
+        PageId pid;
+        Page *page = nullptr;
+        size_t pos = 0;
+        latch_t mode = latch_t::NONE;
+
+        friend class BufferPool;
+
+        PageGuard(BufferPool &pool, const PageId &pid, size_t pos, latch_t mode);
+
+    public:
+        PageGuard() = default;
+
+        ~PageGuard();
+
+        PageGuard(const PageGuard &) = delete;
+
+        PageGuard &operator=(const PageGuard &) = delete;
+
+        PageGuard(PageGuard &&other) noexcept;
+
+        PageGuard &operator=(PageGuard &&other) noexcept;
+
+        Page &operator*() const { return *page; }
+
+        Page *operator->() const { return page; }
+
+        explicit operator bool() const { return pool != nullptr; }
+
+        const PageId &getPageId() const { return pid; }
+
+        /**
+         * @brief: Marks the guarded page as dirty.
+         */
+        void markDirty() const;
+
+        /**
+         * @brief: Releases the latch and unpins the page. Does nothing if the guard is empty.
+         */
+        void release();
+    };
+
 /**
  * @brief Represents a buffer pool for database pages.
  * @details The BufferPool class is responsible for managing the database pages in memory.
  * It provides functions to get a page, mark a page as dirty, and check the status of pages.
  * The class also supports flushing pages to disk and discarding pages from the buffer pool.
- * @note A BufferPool owns the Page objects that are stored in it.
+ * @note A BufferPool owns the Page objects that are stored in it. The frames are held in a single arena that starts at a
+ * multiple of DEFAULT_PAGE_SIZE (also when it is larger than the system page), so every frame is aligned to
+ * DEFAULT_PAGE_SIZE and can be transferred with direct I/O (see DbFileOptions::direct_io).
+ * @note The pool is split in shards that own a contiguous range of frames. A page always maps to the same shard (by
+ * the hash of its id), so threads accessing pages of different shards do not contend on the same latch. All methods
+ * are thread-safe, but a returned Page reference may be evicted by another thread's getPage.
+ * @note Hits do not take the shard latch: the page table is probed optimistically and the frame is pinned with a
+ * compare-and-swap that fails if the frame is being evicted. The frame is queued in its shard, and the replacement
+ * policy is updated from the queue by the next miss or eviction of the shard, in the order of the hits.
  */
     class BufferPool {
+        struct Shard {
+            mutable std::mutex latch;
+            size_t first = 0;
+            size_t count = 0;
+            std::unique_ptr<PageTable> table;
+            std::unordered_set<size_t> dirty;
+            std::vector<size_t> available;
+            std::unordered_set<PageId, std::hash<const PageId>> loading;
+            std::unique_ptr<Replacer> replacer;
+            BufferPoolStats stats;
+            // Frames hit without the latch, waiting to be touched in the replacer. The queue has room for every frame
+            // of the shard, and a frame is queued at most once until it is drained
+            std::unique_ptr<std::atomic<uint64_t>[]> touches;
+            size_t touch_slots = 0;
+            std::atomic<uint64_t> touch_head{0};
+            uint64_t touch_tail = 0;
+            // The backend of the batched I/O on the pages of the shard. Its latch is not the shard latch: read-ahead
+            // submits without the shard latch
+            std::mutex io_latch;
+            std::unique_ptr<IoBackend> io;
+            // The frame (relative to first) where the next sweep of the background writer starts
+            size_t sweep = 0;
+        };
+
+        /**
+         * @brief A sequential run of page accesses in a file.
+         * @details `next` is the page that continues the run and `frontier` the first page not requested yet.
+         */
+        struct Stream {
+            file_id_t file = INVALID_FILE_ID;
+            size_t next = 0;
+            size_t frontier = 0;
+            size_t window = 0;
+            size_t run = 0;
+            uint64_t last_access = 0;
+        };
+
+        /**
+         * @brief The streams of the files that map to the same set.
+         * @details `next_keys` mirrors the key of the page that continues each stream, so that a hit can tell without
+         * the latch whether it moves a stream forward.
+         */
+        struct StreamSet {
+            std::mutex latch;
+            std::array<Stream, READAHEAD_STREAMS> streams;
+            std::array<std::atomic<uint64_t>, READAHEAD_STREAMS> next_keys;
+            uint64_t accesses = 0;
+        };
+
+        /// Set in the pin count of a frame while it is evicted, so that optimistic pins fail
+        static constexpr uint32_t EVICTING = 1u << 31;
+
         // TODO pa0: add private members
-        std::array<Page, DEFAULT_NUM_PAGES> pages;
-        std::array<PageId, DEFAULT_NUM_PAGES> pos_to_pid;
-        std::unordered_map<const PageId, size_t> pid_to_pos;
-        std::unordered_set<size_t> dirty;
-        std::vector<size_t> available;
-        std::list<size_t> lru_list;
-        std::unordered_map<size_t, std::list<size_t>::iterator> pos_to_lru;
+        size_t num_pages;
+        size_t arena_size;
+        Page *pages;
+        std::unique_ptr<std::atomic<PageId>[]> pos_to_pid;
+        std::unique_ptr<std::atomic<uint32_t>[]> pins;
+        std::unique_ptr<std::atomic<bool>[]> touched;
+        std::unique_ptr<std::atomic<size_t>[]> frame_hits;
+        std::unique_ptr<std::shared_mutex[]> frame_latches;
+        // Bumped by every markDirty of the frame (under the latch of its shard), so that a write done without the latch
+        // can tell whether the page was dirtied again meanwhile
+        std::unique_ptr<uint64_t[]> dirty_versions;
+        size_t num_shards;
+        std::unique_ptr<Shard[]> shards;
+        size_t scan_ring_pages;
+
+        double clean_target;
+        size_t writer_pages_per_second;
+        std::chrono::milliseconds writer_interval;
+        std::mutex writer_mutex;
+        std::condition_variable writer_cv;
+        bool stopping = false;
+        std::thread writer;
+        // Copies of the pages the background writer is writing, reused across wakeups
+        std::vector<Page> writer_copies;
+
+        size_t readahead_max_pages;
+        std::mutex readahead_mutex;
+        std::condition_variable readahead_cv;
+        std::unique_ptr<StreamSet[]> stream_sets;
+        std::deque<PageId> prefetch_queue;
+        std::thread prefetcher;
+
+        unsigned io_queue_depth;
+
+        friend class PageGuard;
+
+        Shard &shardOf(const PageId &pid) const;
+
+        size_t lookup(Shard &shard, const PageId &pid, bool pin);
+
+        void applyDeferredTouches(Shard &shard) const;
+
+        bool claim(size_t pos);
+
+        size_t fetch(Shard &shard, const PageId &pid);
+
+        size_t reserveFrame(Shard &shard);
+
+        void install(Shard &shard, const PageId &pid, size_t pos);
+
+        size_t load(Shard &shard, const PageId &pid);
+
+        void recycle(const PageId &pid);
+
+        void unpin(size_t pos);
+
+        void flush(Shard &shard, size_t pos);
+
+        void runRequests(std::span<IoRequest> requests, std::span<Shard *const> request_shards);
+
+        void flushDirty(file_id_t file);
+
+        void discard(Shard &shard, size_t pos, bool evicted = false);
+
+        void evict(Shard &shard, size_t pos);
+
+        void backgroundWriter();
+
+        size_t cleanShard(Shard &shard, size_t budget);
+
+        void noteAccess(const PageId &pid, bool miss);
+
+        void prefetchPages();
+
+        void readAhead(const std::vector<PageId> &batch);
 
     public:
         /**
@@ -33,7 +346,33 @@ namespace db {
         explicit BufferPool();
 
         /**
-         * @brief: Destructs a BufferPool object after flushing all dirty pages to disk.
+         * @brief: Constructs a BufferPool object with the specified options.
+         * @param options: The number of frames, the backing of the frame arena, the replacement policy, the number of
+         * shards and the background writer settings.
+         * @note If clean_target and writer_pages_per_second are positive, a background thread writes dirty unpinned pages
+         * until that share of every shard is clean, so that misses rarely have to write a victim. It sweeps the frames
+         * of each shard in a circle, resuming where it stopped, and copies the pages under a shared frame latch so
+         * that the shard latch is not held while they are written. Rates below one page per wakeup are carried over
+         * to the next wakeups.
+         * @note If readahead_max_pages is positive, getPage and pin detect sequential runs per file and per stream, and a
+         * background thread reads the next pages of a run before they are requested. Only misses and the hits on the
+         * page that continues a stream take the latch of the stream set. The window starts at
+         * READAHEAD_MIN_PAGES and doubles up to readahead_max_pages while the run continues.
+         * @note Read-ahead and flushFile/flushAll submit their pages to the I/O backend in batches of io_queue_depth.
+         * Every shard has its own backend, used for the requests that start with one of its pages, so that the I/O of
+         * different shards does not serialize.
+         * flushFile/flushAll collect the dirty pages of all shards and write them in (file, page) order, with one vectored
+         * write per run of consecutive pages (up to IOV_MAX pages), also when the run spans several shards. The pages
+         * are pinned rather than latched while they are written, and a page dirtied again during its write stays dirty.
+         * @throws std::invalid_argument if the number of pages is zero or smaller than the number of shards, or if the
+         * queue depth is zero.
+         * @throws std::runtime_error if the frame arena cannot be mapped.
+         */
+        explicit BufferPool(const BufferPoolOptions &options);
+
+        /**
+         * @brief: Destructs a BufferPool object after stopping the background threads and flushing all dirty pages to
+         * disk.
          */
         ~BufferPool();
 
@@ -49,10 +388,45 @@ namespace db {
          * @brief: Returns the page with the specified page id.
          * @param pid: The page id of the page to return.
          * @return: The page with the specified page id.
-         * @note This method should make this page the most recently used page.
+         * @note This method records an access to the page with the replacement policy.
+         * @note The page is not pinned: it may be evicted by the next getPage. Use BufferPool::pin to keep it.
+         * @throws std::runtime_error if the page is not resident and every frame of its shard is pinned.
          */
         Page &getPage(const PageId &pid);
 
+        /**
+         * @brief: Returns a pinned handle to the page with the specified page id.
+         * @param pid: The page id of the page to pin.
+         * @param mode: The latch to hold on the page while the guard is alive.
+         * @param ring: If not null, a miss recycles the oldest frame of the ring and the page joins the ring.
+         * @return: A guard that keeps the page resident until it is destroyed.
+         * @note This method records an access to the page with the replacement policy.
+         * @note With a sharded pool the recycled frame returns to the shard of the old page, so the new page may still
+         * evict a page of its own shard.
+         * @throws std::runtime_error if the page is not resident and every frame of its shard is pinned.
+         */
+        PageGuard pin(const PageId &pid, latch_t mode = latch_t::NONE, BufferRing *ring = nullptr);
+
+        /**
+         * @brief: Returns a ring for a sequential scan of a file, or null if the scan should use the pool normally.
+         * @param file_pages: The number of pages of the scanned file.
+         * @return: A ring of scan_ring_pages frames if the file is larger than the pool, null otherwise.
+         */
+        std::shared_ptr<BufferRing> makeScanRing(size_t file_pages) const;
+
+        /**
+         * @brief: Reads a page into a free frame, without evicting anything or recording an access.
+         * @param pid: The page id of the page to read.
+         * @return: True if the page is resident afterwards, false if its shard has no free frame left.
+         */
+        bool preload(const PageId &pid);
+
+        /**
+         * @brief: Returns the resident pages, the most recently used first.
+         * @note With several shards, the recency order is only kept within a shard: the shards are interleaved.
+         */
+        std::vector<PageId> residentPages() const;
+
         /**
          * @brief: Marks the page with the specified page id as dirty.
          * @param pid: The page id of the page to mark as dirty.
@@ -77,10 +451,21 @@ namespace db {
          * @brief: Discards the page with the specified page id from the buffer pool.
          * @param pid: The page id of the page to discard.
          * @note This method does NOT flush the page to disk.
-         * @note This method also updates the LRU and dirty pages to exclude tracking this page.
+         * @note This method also updates the replacement policy and dirty pages to exclude tracking this page.
+         * @throws std::logic_error if the page is pinned.
          */
         void discardPage(const PageId &pid);
 
+        /**
+         * @brief: Discards every page of the specified file from the buffer pool.
+         * @param file: The file id of the associated file.
+         * @note This method does NOT flush the pages to disk. Reads ahead of the file that are in flight are dropped.
+         * @note Database::remove calls it, so that a file added later under the same name (and file id) does not find
+         * the pages of the removed one.
+         * @throws std::logic_error if a page of the file is pinned.
+         */
+        void discardFile(file_id_t file);
+
         /**
          * @brief: Flushes the page with the specified page id to disk.
          * @param pid: The page id of the page to flush.
@@ -94,5 +479,37 @@ namespace db {
          * @note This method should call BufferPool::flushPage(pid).
          */
         void flushFile(const std::string &file);
+
+        /**
+         * @brief: Flushes all dirty pages in the specified file to disk.
+         * @param file: The file id of the associated file.
+         */
+        void flushFile(file_id_t file);
+
+        /**
+         * @brief: Flushes all dirty pages to disk.
+         */
+        void flushAll();
+
+        /**
+         * @brief: Returns the number of frames in the buffer pool.
+         */
+        size_t size() const;
+
+        /**
+         * @brief: Returns the number of shards of the buffer pool.
+         */
+        size_t getNumShards() const;
+
+        /**
+         * @brief: Returns the counters and the miss latency histogram (summed over all shards) since construction or the
+         * last reset.
+         */
+        BufferPoolStats getStats() const;
+
+        /**
+         * @brief: Resets the counters and the miss latency histogram.
+         */
+        void resetStats();
     };
 } // namespace db
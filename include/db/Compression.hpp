@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace db {
+    /**
+     * @brief The on-disk format of the pages of a DbFile.
+     * @details NONE stores every page at its offset in the file. LZ compresses every page with lzCompress and stores it
+     * through a PageMap.
+     */
+    enum class compression_t {
+        NONE, LZ
+    };
+
+    /**
+     * @brief: Compresses a block with a byte-oriented LZ77 encoding (in the style of LZ4).
+     * @details The block is a sequence of (literals, match) pairs. Every pair starts with a token byte holding the
+     * number of literals in its high nibble and the match length minus 4 in its low nibble (15 means that more length
+     * bytes follow, each adding up to 255). The literals follow, then the offset of the match as 2 little-endian bytes.
+     * The last pair only has literals.
+     * @param src: The block to compress.
+     * @param dst: The buffer of the compressed block.
+     * @return: The size of the compressed block, or 0 if it does not fit in `dst`.
+     */
+    size_t lzCompress(std::span<const uint8_t> src, std::span<uint8_t> dst);
+
+    /**
+     * @brief: Decompresses a block compressed by lzCompress.
+     * @param src: The compressed block.
+     * @param dst: The buffer of the block, which must have exactly the size of the uncompressed block.
+     * @throws std::runtime_error if the compressed block is corrupt or does not decompress to `dst.size()` bytes.
+     */
+    void lzDecompress(std::span<const uint8_t> src, std::span<uint8_t> dst);
+} // namespace db
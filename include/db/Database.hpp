@@ -2,7 +2,10 @@
 
 #include <db/BufferPool.hpp>
 #include <db/DbFile.hpp>
+#include <atomic>
 #include <memory>
+#include <shared_mutex>
+#include <thread>
 
 /**
  * @brief A database is a collection of files and a BufferPool.
@@ -10,15 +13,30 @@
  * It provides functions to add new database files, get the internal id of a file, and retrieve database files.
  * The class also supports removing all files from the catalog.
  * @note A Database owns the DbFile objects that are added to it.
+ * @note File names are interned: a name keeps the same file id for the lifetime of the Database.
+ * @note The catalog is guarded by a reader-writer latch, so files can be looked up from several threads.
  */
 namespace db {
     class Database {
         // TODO pa0: add private members
-        std::unordered_map<std::string, std::unique_ptr<DbFile>> files;
+        mutable std::shared_mutex latch;
+        std::unordered_map<std::string, file_id_t> ids;
+        std::vector<std::unique_ptr<DbFile>> files;
 
-        BufferPool bufferPool;
+        std::unique_ptr<BufferPool> bufferPool;
 
-        Database() = default;
+        std::string warmup_path;
+        std::thread warmup;
+        std::atomic<bool> warmup_stop = false;
+        std::atomic<size_t> warmup_loaded = 0;
+
+        void preload(std::string path);
+
+        void stopWarmup();
+
+        Database();
+
+        ~Database();
 
     public:
         friend Database &getDatabase();
@@ -37,11 +55,20 @@ namespace db {
          */
         BufferPool &getBufferPool();
 
+        /**
+         * @brief Replaces the BufferPool with one built from the specified options.
+         * @param options The size and backing of the new buffer pool.
+         * @note All dirty pages of the current buffer pool are flushed before it is replaced.
+         * @note References to pages of the current buffer pool are invalidated. This method must not be called while
+         * other threads use the buffer pool.
+         */
+        void configureBufferPool(const BufferPoolOptions &options);
+
         /**
          * @brief Adds a new file to the Database.
          * @param file The file to add.
          * @throws std::logic_error if the file name already exists.
-         * @note This method takes ownership of the DbFile.
+         * @note This method takes ownership of the DbFile and assigns it the file id of its name.
          */
         void add(std::unique_ptr<DbFile> file);
 
@@ -51,6 +78,8 @@ namespace db {
          * @return The removed file.
          * @throws std::logic_error if the name does not exist.
          * @note This method should call BufferPool::flushFile(name)
+         * @note The pages of the file are then discarded from the BufferPool.
+         * @throws std::logic_error if a page of the file is pinned.
          * @note This method moves the DbFile ownership to the caller.
          */
         std::unique_ptr<DbFile> remove(const std::string &name);
@@ -62,6 +91,44 @@ namespace db {
          * @throws std::logic_error if the name does not exist.
          */
         DbFile &get(const std::string &name) const;
+
+        /**
+         * @brief Returns the DbFile of the specified id.
+         * @param id The file id assigned by Database::add.
+         * @return The DbFile object.
+         * @throws std::logic_error if no file with this id is in the Database.
+         */
+        DbFile &get(file_id_t id) const;
+
+        /**
+         * @brief Returns the file id interned for the specified name.
+         * @param name The name of the file.
+         * @throws std::out_of_range if no file with this name was ever added.
+         */
+        file_id_t getFileId(const std::string &name) const;
+
+        /**
+         * @brief Writes the resident pages of the BufferPool to a warm-up list, the most recently used first.
+         * @param path The file to write. It is replaced atomically.
+         * @throws std::runtime_error if the list cannot be written.
+         * @note The pages are stored with their file names, since file ids are only valid within a process.
+         */
+        void saveWarmupList(const std::string &path) const;
+
+        /**
+         * @brief Starts preloading the pages of a warm-up list in the background, and saves the list again at shutdown.
+         * @param path The warm-up list written by saveWarmupList. A missing list is ignored.
+         * @details The most recently used pages that fit in the free frames of the pool are read in (file, page)
+         * order, so that the reads are mostly sequential. Pages of files that are not added yet are skipped, so the
+         * files should be added first. Preloading never evicts a page and does not block the caller.
+         */
+        void startWarmup(const std::string &path);
+
+        /**
+         * @brief Waits until the pages of the warm-up list are preloaded.
+         * @return The number of pages of the list that were resident after the warm-up.
+         */
+        size_t waitForWarmup();
     };
 
 /**
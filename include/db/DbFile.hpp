@@ -1,10 +1,64 @@
 #pragma once
 
+#include <db/Compression.hpp>
+#include <db/IoBackend.hpp>
 #include <db/Iterator.hpp>
+#include <db/Metrics.hpp>
+#include <db/PageMap.hpp>
 #include <db/types.hpp>
+#include <atomic>
+#include <memory>
+#include <span>
 #include <vector>
 
 namespace db {
+    constexpr size_t DEFAULT_EXTENT_PAGES = 16;
+
+/**
+ * @brief The expected access pattern of a memory-mapped file, passed to the kernel with madvise.
+ */
+    enum class access_t {
+        NORMAL, SEQUENTIAL, RANDOM
+    };
+
+/**
+ * @brief The page format of a HeapFile.
+ */
+    enum class heap_layout_t {
+        /// Fixed-width tuples in a slot array with an occupancy bitmap (HeapPage)
+        FIXED,
+        /// Variable-length tuples behind a slot directory (SlottedPage), so that short strings pack densely
+        SLOTTED
+    };
+
+/**
+ * @brief Options used to open a DbFile.
+ */
+    struct DbFileOptions {
+        /// Open the file with O_DIRECT, so that pages are only cached by the BufferPool and not also by the OS page cache.
+        /// Falls back to buffered I/O if the filesystem rejects O_DIRECT or needs a larger alignment than a page.
+        bool direct_io = false;
+
+        /// Open an existing file read-only and map it into memory. Files that support it (HeapFile) read their tuples
+        /// straight from the mapping instead of the BufferPool. The file must not change while it is mapped.
+        bool mmap = false;
+
+        /// The access pattern hint of a mapped file.
+        access_t access = access_t::NORMAL;
+
+        /// The number of pages reserved on disk (with fallocate) whenever the file grows past its reserved space, so
+        /// that a growing file stays contiguous. 0 disables preallocation.
+        size_t extent_pages = DEFAULT_EXTENT_PAGES;
+
+        /// Compress every page when it is written and decompress it when it is read. The compressed pages are packed in
+        /// the file and located through a PageMap stored next to it, in `<name>.map`. A compressed file cannot be
+        /// mapped or opened with direct I/O, and its pages cannot be transferred with an IoBackend.
+        compression_t compression = compression_t::NONE;
+
+        /// The page format of a HeapFile (ignored by other files). It is recorded in the free-space map of the file, and
+        /// opening the file with another layout throws std::invalid_argument.
+        heap_layout_t layout = heap_layout_t::FIXED;
+    };
 
 /**
  * @brief Represents a database file.
@@ -13,17 +67,59 @@ namespace db {
  * @note A `DbFile` object owns the `TupleDesc` object that describes the schema of the tuples in the file.
  */
     class DbFile {
-        mutable std::vector<size_t> reads;
-        mutable std::vector<size_t> writes;
+        mutable TraceRing reads;
+        mutable TraceRing writes;
+        mutable IoMetrics metrics;
 
         // TODO pa1: add private members
         int fd;
+        mutable std::atomic<bool> direct = false;
+        bool mapped = false;
+        const uint8_t *mapping = nullptr;
+        size_t mappedPages = 0;
+        size_t extentPages;
+        size_t allocatedPages;
+        std::unique_ptr<PageMap> pageMap;
+
+        void disableDirectIo() const;
+
+        void checkWritable() const;
+
+        void checkUncompressed() const;
+
+        void readCompressed(Page &page, size_t id) const;
+
+        void writeCompressed(const Page &page, size_t id) const;
+
+        friend class Database;
 
     protected:
+        file_id_t file_id = INVALID_FILE_ID;
         const std::string name;
         const TupleDesc td;
         size_t numPages;
 
+        /**
+         * @brief Appends a page to the file.
+         * @details The page only becomes part of the file on disk when it is written. Whenever the file grows past the
+         * space reserved on disk, the next extent of `DbFileOptions::extent_pages` pages is reserved with fallocate
+         * (without changing the file size).
+         * @return The page number of the new page.
+         * @throws std::logic_error if the file is mapped.
+         * @throws std::out_of_range if the file already has the maximum number of pages of a PageId.
+         */
+        size_t allocatePage();
+
+        /**
+         * @brief Drops the pages of the file from `pages` on.
+         * @details The file is truncated on disk, which also releases its preallocated extent. A compressed file drops
+         * the pages from its PageMap instead, and reuses their space for later pages.
+         * @note The caller must discard the dropped pages from the BufferPool first, or they would be written back.
+         * @throws std::logic_error if the file is mapped.
+         * @throws std::runtime_error if the `ftruncate` system call fails.
+         */
+        void truncatePages(size_t pages);
+
     public:
         /**
          * @brief Construct a new Db File object with the specified file name and tuple descriptor
@@ -35,6 +131,17 @@ namespace db {
          */
         explicit DbFile(const std::string &name, const TupleDesc &td);
 
+        /**
+         * @brief Construct a new Db File object with the specified file name, tuple descriptor and options.
+         * @param name of the file to be opened or created.
+         * @param td tuple description of tuples in the file.
+         * @param options how the file is opened.
+         * @throws std::runtime_error if the file cannot be opened or if the `fstat` or `mmap` system call fails.
+         * @throws std::invalid_argument if compression is combined with mmap or direct I/O.
+         * @note With `options.mmap` the file is not created: it must exist.
+         */
+        DbFile(const std::string &name, const TupleDesc &td, const DbFileOptions &options);
+
         /**
          * @brief closes the file descriptor.
          */
@@ -42,27 +149,144 @@ namespace db {
 
         const std::string &getName() const;
 
-        const std::vector<size_t> &getReads() const;
+        /**
+         * @brief Returns the file id assigned when the file was added to the Database.
+         * @return The file id, or INVALID_FILE_ID if the file was never added.
+         */
+        file_id_t getId() const;
+
+        /**
+         * @brief Returns whether the pages of the file bypass the OS page cache (O_DIRECT).
+         * @note This is false if direct I/O was not requested or the filesystem does not support it.
+         */
+        bool isDirect() const;
 
-        const std::vector<size_t> &getWrites() const;
+        /**
+         * @brief Returns whether the pages are stored compressed (see DbFileOptions::compression).
+         */
+        bool isCompressed() const;
+
+        /**
+         * @brief Returns whether the file is mapped read-only into memory (see DbFileOptions::mmap).
+         */
+        bool isMapped() const;
+
+        /**
+         * @brief Returns a page of a mapped file, without copying it.
+         * @param id The page number. A page past the end of the file reads as zeros, like with readPage.
+         * @throws std::logic_error if the file is not mapped.
+         */
+        const Page &mappedPage(size_t id) const;
+
+        /**
+         * @brief Changes the access pattern hint of a mapped file.
+         * @throws std::logic_error if the file is not mapped.
+         */
+        void advise(access_t access) const;
+
+        /**
+         * @brief Returns the trace of the page numbers read, in order. Only the most recent entries are kept.
+         */
+        const TraceRing &getReads() const;
+
+        /**
+         * @brief Returns the trace of the page numbers written, in order. Only the most recent entries are kept.
+         */
+        const TraceRing &getWrites() const;
+
+        /**
+         * @brief Changes the number of entries kept by the read and write traces and clears them.
+         * @param capacity The number of entries to keep (0 only counts the pages).
+         */
+        void setTraceCapacity(size_t capacity);
+
+        /**
+         * @brief Returns the I/O counters and latency histograms of the file since construction or the last reset.
+         */
+        IoStats getIoStats() const;
+
+        /**
+         * @brief Resets the I/O counters, the latency histograms and the traces.
+         */
+        void resetIoStats();
 
         /**
          * @brief Read a page from the file.
-         * @param page The page to read into.
+         * @param page The page to read into. With direct I/O, a page that is not aligned to DEFAULT_PAGE_SIZE is read
+         * through an aligned bounce buffer. A mapped file copies the page from the mapping, and a compressed file
+         * decompresses it.
          * @param id The page number of the page to be read. It determines the offset within the file.
          */
         void readPage(Page &page, size_t id) const;
 
+        /**
+         * @brief Read consecutive pages from the file, with one preadv per run of up to IOV_MAX pages.
+         * @param first The page number of the first page.
+         * @param frames The pages to read into, one per page starting at `first`. With direct I/O, if a frame is not
+         * aligned to DEFAULT_PAGE_SIZE, or if the file is mapped or compressed, the pages are read one at a time, as with
+         * readPage.
+         * @note The pages are counted one by one in the read trace and statistics.
+         */
+        void readPages(size_t first, std::span<Page *const> frames) const;
+
         /**
          * @brief Write a page to the file.
-         * @param page The page to write.
+         * @param page The page to write. With direct I/O, a page that is not aligned to DEFAULT_PAGE_SIZE is written
+         * through an aligned bounce buffer. A compressed file compresses the page and stores it where its PageMap
+         * places it; a page that does not compress is stored as is.
          * @param id The page number of the page to which the data will be written.
          * It determines the offset in the file.
+         * @throws std::logic_error if the file is mapped.
+         * @throws std::runtime_error if the page cannot be written in full.
          */
         void writePage(const Page &page, size_t id) const;
 
+        /**
+         * @brief Prepare an asynchronous read of a page, to be submitted to an IoBackend.
+         * @param page The page to read into. It is zero-filled so that a short read leaves zeros. With direct I/O it
+         * must be aligned to DEFAULT_PAGE_SIZE, like the frames of the BufferPool.
+         * @param id The page number of the page to be read.
+         * @return The request, counted as a read of the file.
+         * @throws std::logic_error if the file is compressed.
+         */
+        IoRequest readRequest(Page &page, size_t id) const;
+
+        /**
+         * @brief Prepare an asynchronous vectored read of consecutive pages, to be submitted to an IoBackend.
+         * @param pages One iovec of DEFAULT_PAGE_SIZE bytes per page, zero-filled like with readRequest. The array must
+         * outlive the request.
+         * @param first The page number of the first page. It determines the offset in the file.
+         * @return The request, counted as one read per page.
+         * @throws std::logic_error if the file is compressed.
+         */
+        IoRequest readRequest(std::span<const iovec> pages, size_t first) const;
+
+        /**
+         * @brief Prepare an asynchronous write of a page, to be submitted to an IoBackend.
+         * @param page The page to write. It must not change until the request completes.
+         * @param id The page number of the page to which the data will be written.
+         * @return The request, counted as a write of the file.
+         * @throws std::logic_error if the file is mapped or compressed.
+         */
+        IoRequest writeRequest(const Page &page, size_t id) const;
+
+        /**
+         * @brief Prepare an asynchronous vectored write of consecutive pages, to be submitted to an IoBackend.
+         * @param pages One iovec of DEFAULT_PAGE_SIZE bytes per page. The array must outlive the request.
+         * @param first The page number of the first page. It determines the offset in the file.
+         * @return The request, counted as one write per page.
+         * @throws std::logic_error if the file is mapped or compressed.
+         */
+        IoRequest writeRequest(std::span<const iovec> pages, size_t first) const;
+
         virtual void insertTuple(const Tuple &t);
 
+        /**
+         * @brief Insert several tuples.
+         * @details The default inserts the tuples one at a time with insertTuple; formats can fill a page at a time.
+         */
+        virtual void insertTuples(std::span<const Tuple> tuples);
+
         virtual void deleteTuple(const Iterator &it);
 
         virtual Tuple getTuple(const Iterator &it) const;
@@ -75,6 +299,12 @@ namespace db {
 
         size_t getNumPages() const;
 
+        /**
+         * @brief Returns the number of pages reserved on disk: the pages of the file and its preallocated extent.
+         * @note Preallocated space past the end of the file is released when the file is closed.
+         */
+        size_t getAllocatedPages() const;
+
         const TupleDesc &getTupleDesc() const;
     };
 } // namespace db
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace db {
+    /**
+     * @brief Tracks the pages of a HeapFile that have a free slot, so that inserts reuse the slots of deleted tuples.
+     * @details A bitmap with one bit per page, set when a tuple of the page is deleted and cleared when an insert finds
+     * the page full. It is kept in memory and in a sidecar file, where the 64-bit word of a bit is rewritten whenever the
+     * bit changes. The map is only a hint: a page found through it must still be checked for room.
+     * @note The sidecar file starts with a header that records the format of the pages of the file (e.g. its
+     * heap_layout_t), so that the file cannot be opened with another format by mistake.
+     */
+    class FreeSpaceMap {
+        int fd;
+        std::vector<uint64_t> words;
+
+        /// No word before this one has a bit set
+        size_t first = 0;
+        mutable std::mutex mutex;
+
+        void store(size_t word);
+
+    public:
+        /// Returned by find when no page has a free slot
+        static constexpr size_t NONE = SIZE_MAX;
+
+        /**
+         * @brief Opens (or creates) the map stored at `path`.
+         * @param format The format of the pages, recorded when the map is created and checked when it is opened.
+         * @throws std::runtime_error if the file cannot be opened or read, or has no valid header.
+         * @throws std::invalid_argument if the map was created with another format.
+         */
+        FreeSpaceMap(const std::string &path, uint32_t format);
+
+        /**
+         * @brief Checks the format recorded in the map stored at `path`, without opening the map for writing.
+         * @details Nothing is checked if there is no map at `path`.
+         * @throws std::runtime_error if the file has no valid header.
+         * @throws std::invalid_argument if the map was created with another format.
+         */
+        static void checkFormat(const std::string &path, uint32_t format);
+
+        ~FreeSpaceMap();
+
+        FreeSpaceMap(const FreeSpaceMap &) = delete;
+
+        FreeSpaceMap &operator=(const FreeSpaceMap &) = delete;
+
+        /**
+         * @brief Returns the first page marked as having a free slot, or NONE.
+         */
+        size_t find();
+
+        /**
+         * @brief Marks whether a page has a free slot.
+         */
+        void set(size_t page, bool free);
+
+        /**
+         * @brief Forgets the pages from `pages` on, after the file was truncated.
+         */
+        void truncate(size_t pages);
+    };
+} // namespace db
@@ -1,22 +1,98 @@
 #pragma once
 
 #include <db/DbFile.hpp>
+#include <db/FreeSpaceMap.hpp>
+#include <memory>
 
 namespace db {
+class HeapPage;
+
 class HeapFile : public DbFile {
+  /// The pages with free slots (null for a mapped file)
+  std::unique_ptr<FreeSpaceMap> fsm;
+
+  /// The page format of the file
+  const heap_layout_t layout;
+
+  /**
+   * @brief Calls `f` with `page` wrapped in the page format of the file (a HeapPage or a SlottedPage).
+   * @return The result of `f`.
+   */
+  template<typename F>
+  auto onPage(Page &page, F &&f) const;
+
+  /**
+   * @brief Calls `f` with a page of the file, read straight from the mapping of a mapped file or pinned in the
+   * BufferPool (through `ring`, if not null) otherwise.
+   * @return The result of `f`.
+   */
+  template<typename F>
+  auto withPage(size_t page, BufferRing *ring, F &&f) const;
+
+  /**
+   * @brief Insert the first tuples of `tuples` to a page through the BufferPool and drop them from `tuples`.
+   * @return true if every tuple was inserted, false if the page is full.
+   */
+  bool fillPage(size_t page, std::span<const Tuple> &tuples);
+
 public:
-  HeapFile(const std::string &name, const TupleDesc &td);
+  /**
+   * @brief Open a heap file.
+   * @note With `options.mmap` the file is read-only: the tuples are read from the mapping and never enter the
+   * BufferPool, and insertTuple and deleteTuple throw std::logic_error.
+   * @note The free-space map of the file is stored next to it, in `<name>.fsm`.
+   * @note With `options.layout` set to heap_layout_t::SLOTTED the pages are SlottedPages, which store the tuples with
+   * variable length. A page then holds as many tuples as their actual sizes allow.
+   * @throws std::invalid_argument if the file was created with another layout.
+   */
+  HeapFile(const std::string &name, const TupleDesc &td, const DbFileOptions &options = {});
 
   /**
    * @brief Insert a tuple to the database file.
-   * @details Insert a tuple to the first available slot of the last page. If the last page is full, create a new page.
+   * @details Insert a tuple to the first available slot of the first page with a free slot according to the free-space
+   * map, or else of the last page. If the last page is full, create a new page.
    * @param t The tuple to be inserted.
    */
   void insertTuple(const Tuple &t) override;
 
+  /**
+   * @brief Insert tuples to the database file, a page at a time.
+   * @details Fill the pages with free slots according to the free-space map, then the last page, then new pages. Every
+   * page is pinned and marked dirty once for all the tuples it receives.
+   * @param tuples The tuples to be inserted.
+   * @throws std::runtime_error if a tuple is not compatible with the TupleDesc (before anything is inserted).
+   */
+  void insertTuples(std::span<const Tuple> tuples) override;
+
+  /**
+   * @brief Append tuples to the database file, building the new pages outside the BufferPool.
+   * @details Fill the last page through the BufferPool, then build every new page in a private buffer and write it
+   * directly to the file, without evicting the pool. Meant for bulk loads: nothing else may insert into the file
+   * meanwhile.
+   * @param tuples The tuples to be appended.
+   * @throws std::runtime_error if a tuple is not compatible with the TupleDesc (before anything is inserted).
+   */
+  void appendTuples(std::span<const Tuple> tuples);
+
+  /**
+   * @brief Compact the end of the file: move its tuples into the free space of earlier pages and truncate the file.
+   * @details Empty the last page by inserting its tuples into the pages with free space according to the free-space
+   * map, then drop it, and repeat for at most `max_pages` pages. The pass stops early when the tuples of the last page
+   * do not fit in the earlier pages. Calling it repeatedly with a small `max_pages` compacts the file in bounded steps
+   * that can be interleaved with other work; once it returns 0 the file is as short as its tuples allow.
+   * @param max_pages The maximum number of pages to empty.
+   * @return The number of pages removed from the file.
+   * @note Moved tuples change position: iterators into the file are invalidated.
+   * @note An emptied page that is still pinned is not dropped, and neither are the pages before it: the file is only
+   * truncated after it, and a later call can drop it once it is unpinned.
+   * @throws std::logic_error if the file is mapped.
+   */
+  size_t compact(size_t max_pages = SIZE_MAX);
+
   /**
    * @brief Delete a tuple from the database file.
-   * @details Delete a tuple from the database file by marking the slot unused.
+   * @details Delete a tuple from the database file by marking the slot unused. The page is marked in the free-space map
+   * so that its slot is reused.
    * @param it The iterator that identifies the tuple to be deleted.
    */
   void deleteTuple(const Iterator &it) override;
@@ -42,6 +118,8 @@ public:
    * @details Get the iterator to the first tuple by finding the first occupied slot.
    * @return The iterator to the first tuple.
    * @note The first tuple may not be on the first page.
+   * @note If the file is larger than the buffer pool, the iterator reads the file through a scan ring (see
+   * BufferPool::makeScanRing) so that the scan does not evict the rest of the pool.
    */
   Iterator begin() const override;
 
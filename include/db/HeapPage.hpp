@@ -9,6 +9,13 @@ class HeapPage {
   uint8_t *header;
   uint8_t *data;
 
+  /**
+   * @brief Find the first slot from `slot` on that is occupied (or free).
+   * @details The header is scanned 64 slots at a time with count-leading-zeros.
+   * @return The slot found, or capacity if there is none.
+   */
+  size_t find(size_t slot, bool occupied) const;
+
 public:
   /**
    * @brief Wrap a page with a heap page.
@@ -40,6 +47,14 @@ public:
    */
   bool insertTuple(const Tuple &t);
 
+  /**
+   * @brief Insert tuples to the page until it is full.
+   * @details The free slots are filled in order, scanning the header once.
+   * @param tuples The tuples to be inserted, in order.
+   * @return The number of tuples inserted (a prefix of `tuples`).
+   */
+  size_t insertTuples(std::span<const Tuple> tuples);
+
   /**
    * @brief Delete a tuple from the page.
    * @details Delete a tuple from the page by marking the slot unused.
@@ -13,7 +13,15 @@ struct IndexPageHeader {
 };
 
 struct IndexPage {
-  uint16_t capacity;
+  /// The number of keys in a full page. The page has room for one more key and child, and the children array
+  /// starts right after the keys, so it has to stay aligned for size_t.
+  static constexpr uint16_t capacity = [] {
+    size_t slots = (DEFAULT_PAGE_SIZE - sizeof(IndexPageHeader)) / (sizeof(int) + sizeof(size_t));
+    while ((sizeof(IndexPageHeader) + slots * sizeof(int)) % alignof(size_t) != 0) {
+      --slots;
+    }
+    return slots - 1;
+  }();
 
   IndexPageHeader *header;
   int *keys;
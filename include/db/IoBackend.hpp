@@ -0,0 +1,152 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <span>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <vector>
+
+namespace db {
+
+/**
+ * @brief The I/O backends used to read and write pages in batches.
+ * @details SYNC performs every request with a blocking pread/pwrite when it is submitted.
+ * IO_URING queues the requests on a Linux io_uring and reaps their completions asynchronously.
+ */
+enum class io_backend_t {
+    SYNC, IO_URING
+};
+
+/**
+ * @brief A read or write of one buffer, or of consecutive pages scattered in memory.
+ * @details If `iov` is set the request is vectored (preadv/pwritev) and `buffer`/`length` are ignored. The request,
+ * its buffers and its iovec array must stay alive until it is returned by IoBackend::reap.
+ */
+struct IoRequest {
+    int fd = -1;
+    bool write = false;
+    void *buffer = nullptr;
+    size_t length = 0;
+    off_t offset = 0;
+    const iovec *iov = nullptr;
+    unsigned iovcnt = 0;
+
+    /// The number of bytes transferred, or -errno if the request failed
+    ssize_t result = 0;
+};
+
+/**
+ * @brief Submits batches of page I/O and reaps their completions.
+ * @note An IoBackend is not thread-safe.
+ */
+class IoBackend {
+public:
+    virtual ~IoBackend() = default;
+
+    /**
+     * @brief: Submits a batch of requests.
+     * @param requests: The requests to submit.
+     */
+    virtual void submit(std::span<IoRequest *const> requests) = 0;
+
+    /**
+     * @brief: Waits for completed requests.
+     * @param min_complete: The minimum number of completions to wait for.
+     * @return: The completed requests, in completion order.
+     */
+    virtual std::vector<IoRequest *> reap(size_t min_complete) = 0;
+
+    /**
+     * @brief: Returns the number of submitted requests that were not reaped yet.
+     */
+    virtual size_t inflight() const = 0;
+
+    /**
+     * @brief: Submits a batch of requests and waits until all of them complete.
+     * @param requests: The requests to perform.
+     */
+    void run(std::span<IoRequest> requests);
+};
+
+/**
+ * @brief Performs every request with a blocking pread/pwrite when it is submitted.
+ */
+class SyncIoBackend : public IoBackend {
+    std::vector<IoRequest *> completed;
+
+public:
+    void submit(std::span<IoRequest *const> requests) override;
+
+    std::vector<IoRequest *> reap(size_t min_complete) override;
+
+    size_t inflight() const override;
+};
+
+/**
+ * @brief Queues requests on a Linux io_uring (raw system calls, no liburing).
+ * @note Requires the IORING_OP_READ(V) and IORING_OP_WRITE(V) operations (Linux 5.6), which are probed when the ring
+ * is set up.
+ */
+class UringIoBackend : public IoBackend {
+    int ring_fd = -1;
+    unsigned entries = 0;
+    void *sq_ring = nullptr;
+    void *cq_ring = nullptr;
+    size_t sq_ring_size = 0;
+    size_t cq_ring_size = 0;
+    void *sqes = nullptr;
+    size_t sqes_size = 0;
+    unsigned *sq_head = nullptr;
+    unsigned *sq_tail = nullptr;
+    unsigned *sq_mask = nullptr;
+    unsigned *sq_array = nullptr;
+    unsigned *cq_head = nullptr;
+    unsigned *cq_tail = nullptr;
+    unsigned *cq_mask = nullptr;
+    void *cqes = nullptr;
+    size_t queued = 0;
+    size_t in_kernel = 0;
+    std::vector<IoRequest *> completed;
+
+    void enter(unsigned to_submit, unsigned min_complete);
+
+    void drainCompletions();
+
+    void unmap();
+
+    /**
+     * @brief Returns whether the kernel supports all the operations `ops` (probed with IORING_REGISTER_PROBE).
+     */
+    bool supports(std::initializer_list<uint8_t> ops) const;
+
+public:
+    /**
+     * @brief: Sets up an io_uring with the specified number of submission queue entries.
+     * @throws std::runtime_error if io_uring or one of the operations it needs is not available.
+     */
+    explicit UringIoBackend(unsigned queue_depth);
+
+    ~UringIoBackend() override;
+
+    UringIoBackend(const UringIoBackend &) = delete;
+
+    UringIoBackend &operator=(const UringIoBackend &) = delete;
+
+    void submit(std::span<IoRequest *const> requests) override;
+
+    std::vector<IoRequest *> reap(size_t min_complete) override;
+
+    size_t inflight() const override;
+};
+
+/**
+ * @brief Creates an I/O backend, falling back to SYNC if io_uring is not available.
+ * @param backend The preferred backend.
+ * @param queue_depth The number of requests the backend can have in flight.
+ */
+std::unique_ptr<IoBackend> makeIoBackend(io_backend_t backend, unsigned queue_depth);
+
+} // namespace db
@@ -1,17 +1,23 @@
 #pragma once
 
 #include <db/Tuple.hpp>
+#include <memory>
 
 namespace db {
     class DbFile;
 
+    class BufferRing;
+
     struct Iterator {
         const DbFile &file;
         size_t page;
         size_t slot;
 
+        /// The frames recycled by a large scan, shared by the copies of the iterator (null for a regular scan)
+        std::shared_ptr<BufferRing> ring;
+
     public:
-        Iterator(const DbFile &file, const size_t &page, size_t slot);
+        Iterator(const DbFile &file, const size_t &page, size_t slot, std::shared_ptr<BufferRing> ring = nullptr);
 
         ~Iterator() = default;
 
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace db {
+    /// Number of power-of-two latency buckets: the last one holds every latency of 2^30 ns (about 1 s) or more
+    constexpr size_t LATENCY_BUCKETS = 32;
+
+    /// Number of page numbers a TraceRing keeps by default
+    constexpr size_t DEFAULT_TRACE_CAPACITY = 1024;
+
+    /**
+     * @brief A histogram of latencies in power-of-two buckets of nanoseconds.
+     * @details Bucket b counts the latencies in [2^(b-1), 2^b) ns (bucket 0 counts latencies under 1 ns).
+     */
+    struct LatencyHistogram {
+        std::array<uint64_t, LATENCY_BUCKETS> buckets{};
+        uint64_t count = 0;
+        uint64_t total_ns = 0;
+
+        /**
+         * @brief: Records one latency.
+         */
+        void record(std::chrono::nanoseconds latency);
+
+        /**
+         * @brief: Returns the mean latency in nanoseconds (0 if nothing was recorded).
+         */
+        double mean() const;
+
+        /**
+         * @brief: Returns an upper bound of the specified percentile, in nanoseconds.
+         * @param p: The percentile, between 0 and 100.
+         * @return: The upper bound of the bucket holding the percentile (0 if nothing was recorded).
+         */
+        uint64_t percentile(double p) const;
+
+        LatencyHistogram &operator+=(const LatencyHistogram &other);
+    };
+
+    /**
+     * @brief A LatencyHistogram that can be recorded from several threads without a latch.
+     */
+    class AtomicLatencyHistogram {
+        std::array<std::atomic<uint64_t>, LATENCY_BUCKETS> buckets{};
+        std::atomic<uint64_t> total_ns{0};
+
+    public:
+        void record(std::chrono::nanoseconds latency);
+
+        LatencyHistogram snapshot() const;
+
+        void reset();
+    };
+
+    /**
+     * @brief A snapshot of the I/O performed on a file.
+     */
+    struct IoStats {
+        /// The number of pages read
+        size_t reads = 0;
+
+        /// The number of pages written
+        size_t writes = 0;
+
+        /// The number of read calls and batched read requests (a vectored read of several pages counts once)
+        size_t read_requests = 0;
+
+        /// The number of write calls and batched write requests (a vectored write of several pages counts once)
+        size_t write_requests = 0;
+
+        size_t bytes_read = 0;
+
+        size_t bytes_written = 0;
+
+        /// Latency of the synchronous page reads (batched requests are counted but not timed)
+        LatencyHistogram read_latency;
+
+        /// Latency of the synchronous page writes (batched requests are counted but not timed)
+        LatencyHistogram write_latency;
+    };
+
+    /**
+     * @brief The I/O counters of a file, recorded with relaxed atomic increments.
+     */
+    class IoMetrics {
+        std::atomic<size_t> reads{0};
+        std::atomic<size_t> writes{0};
+        std::atomic<size_t> read_requests{0};
+        std::atomic<size_t> write_requests{0};
+        std::atomic<size_t> bytes_read{0};
+        std::atomic<size_t> bytes_written{0};
+        AtomicLatencyHistogram read_latency;
+        AtomicLatencyHistogram write_latency;
+
+    public:
+        void recordRead(size_t pages, size_t bytes);
+
+        void recordWrite(size_t pages, size_t bytes);
+
+        void recordReadLatency(std::chrono::nanoseconds latency);
+
+        void recordWriteLatency(std::chrono::nanoseconds latency);
+
+        IoStats snapshot() const;
+
+        void reset();
+    };
+
+/**
+ * @brief A bounded record of the most recent page numbers read or written.
+ * @details Entries are numbered from 0 in recording order, like a vector, but only the last `capacity` entries are
+ * kept: older ones are overwritten. A capacity of 0 only counts the entries.
+ * @note push is lock-free: it claims a slot with an atomic counter, so it is cheap enough for every page I/O. The
+ * readers are thread-safe, but may return an entry a concurrent push is about to overwrite. setCapacity must not run
+ * concurrently with the other methods.
+ */
+    class TraceRing {
+        std::unique_ptr<std::atomic<size_t>[]> entries;
+        size_t slots;
+        std::atomic<size_t> recorded = 0;
+
+    public:
+        explicit TraceRing(size_t capacity = DEFAULT_TRACE_CAPACITY);
+
+        /**
+         * @brief: Records an entry, overwriting the oldest one if the ring is full.
+         */
+        void push(size_t value);
+
+        /**
+         * @brief: Returns the number of entries recorded since construction or the last clear, including the
+         * overwritten ones.
+         */
+        size_t size() const;
+
+        /**
+         * @brief: Returns the number of entries the ring keeps.
+         */
+        size_t capacity() const;
+
+        /**
+         * @brief: Returns the i-th recorded entry.
+         * @throws std::out_of_range if the entry was not recorded yet or was overwritten.
+         */
+        size_t operator[](size_t i) const;
+
+        /**
+         * @brief: Returns the entries that were not overwritten, oldest first.
+         */
+        std::vector<size_t> retained() const;
+
+        /**
+         * @brief: Forgets all entries.
+         */
+        void clear();
+
+        /**
+         * @brief: Forgets all entries and changes the number of entries the ring keeps.
+         */
+        void setCapacity(size_t capacity);
+    };
+} // namespace db
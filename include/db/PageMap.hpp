@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace db {
+    /// Compressed pages are stored in slots of a multiple of this size, so that a page that grows a little can be
+    /// rewritten in place
+    constexpr size_t PAGE_SLOT_ALIGNMENT = 256;
+
+    /**
+     * @brief The location of a compressed page in its file.
+     */
+    struct PageExtent {
+        uint64_t offset = 0;
+
+        /// The size of the compressed page: 0 if the page was never written, DEFAULT_PAGE_SIZE if it is stored as is
+        uint32_t length = 0;
+
+        /// The size of the slot, from which `length` may grow without moving the page
+        uint32_t capacity = 0;
+    };
+
+    static_assert(sizeof(PageExtent) == 16);
+
+    /**
+     * @brief The indirection map of a compressed DbFile: where every page is stored in the file.
+     * @details The map is kept in memory and in a sidecar file with one PageExtent per page, which is updated every time
+     * a page is placed. A page is rewritten in its slot if it fits, or else moved to the smallest free slot that fits
+     * or to the end of the file. The free slots are the gaps between the slots in use; they are found again when the
+     * map is opened.
+     */
+    class PageMap {
+        int fd;
+        std::vector<PageExtent> extents;
+        std::multimap<uint32_t, uint64_t> free_slots;
+        uint64_t end = 0;
+        mutable std::mutex mutex;
+
+    public:
+        /**
+         * @brief Opens (or creates) the map stored at `path`.
+         * @throws std::runtime_error if the file cannot be opened or read.
+         */
+        explicit PageMap(const std::string &path);
+
+        ~PageMap();
+
+        PageMap(const PageMap &) = delete;
+
+        PageMap &operator=(const PageMap &) = delete;
+
+        /**
+         * @brief Returns the number of pages in the map, written or not.
+         */
+        size_t size() const;
+
+        /**
+         * @brief Returns where a page is stored (an empty extent if the page was never written).
+         */
+        PageExtent get(size_t id) const;
+
+        /**
+         * @brief Finds a slot for a page of `length` bytes and records it in the sidecar file.
+         * @return The extent to write the page to.
+         * @throws std::runtime_error if the sidecar file cannot be written.
+         */
+        PageExtent place(size_t id, uint32_t length);
+
+        /**
+         * @brief Drops the pages from `pages` on: their slots become free.
+         * @throws std::runtime_error if the sidecar file cannot be truncated.
+         */
+        void truncate(size_t pages);
+    };
+} // namespace db
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <db/types.hpp>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace db {
+
+/**
+ * @brief The page table of a BufferPool shard: maps the resident page ids to their frames.
+ * @details An open-addressing hash table with linear probing over a flat array of 16-byte slots (four per cache line),
+ * sized to at least twice the number of frames so that probes stay short. Erasing shifts the following entries back
+ * instead of leaving tombstones. Nothing is allocated after construction.
+ * @note Writers (insert and erase) must be serialized by the caller. find is lock-free and may run concurrently with
+ * a writer: it is validated with a sequence counter and retried if a write overlapped the probe.
+ */
+class PageTable {
+    static constexpr uint64_t EMPTY = UINT64_MAX;
+
+    struct Slot {
+        std::atomic<uint64_t> key{EMPTY};
+        std::atomic<uint64_t> pos{0};
+    };
+
+    std::unique_ptr<Slot[]> slots;
+    size_t mask;
+    unsigned shift;
+    size_t count = 0;
+    std::atomic<uint64_t> version{0};
+
+    size_t home(uint64_t key) const;
+
+    void beginWrite();
+
+    void endWrite();
+
+public:
+    /// Returned by find when the page is not in the table
+    static constexpr size_t NOT_FOUND = SIZE_MAX;
+
+    /**
+     * @brief: Constructs a table that can hold the specified number of entries.
+     */
+    explicit PageTable(size_t max_entries);
+
+    PageTable(const PageTable &) = delete;
+
+    PageTable &operator=(const PageTable &) = delete;
+
+    /**
+     * @brief: Returns the frame of a page, or NOT_FOUND.
+     */
+    size_t find(const PageId &pid) const;
+
+    /**
+     * @brief: Returns the frame of a page.
+     * @throws std::out_of_range if the page is not in the table.
+     */
+    size_t at(const PageId &pid) const;
+
+    /**
+     * @brief: Adds a page that is not in the table.
+     * @throws std::length_error if the table already holds max_entries pages.
+     */
+    void insert(const PageId &pid, size_t pos);
+
+    /**
+     * @brief: Removes a page.
+     * @return: Whether the page was in the table.
+     */
+    bool erase(const PageId &pid);
+
+    size_t size() const { return count; }
+};
+
+} // namespace db
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <db/types.hpp>
+#include <functional>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace db {
+
+/**
+ * @brief The replacement policies supported by the BufferPool.
+ * @details LRU keeps the frames in a recency list.
+ * CLOCK keeps a reference bit per frame and sweeps the frames in a circle to find a victim.
+ * TWO_Q admits new pages to a FIFO queue and only promotes pages that are referenced again after leaving it, so a
+ * single sequential scan cannot evict the frequently used pages.
+ */
+enum class replacement_t {
+    LRU, CLOCK, TWO_Q
+};
+
+/**
+ * @brief Decides which frame of a BufferPool is evicted next.
+ * @details A Replacer tracks the frames that currently hold a page. The BufferPool notifies the replacer when a frame
+ * is filled, accessed and emptied, and asks it for a victim when there are no free frames left.
+ */
+class Replacer {
+public:
+    virtual ~Replacer() = default;
+
+    /**
+     * @brief: Starts tracking a frame that was just filled with a page.
+     * @param frame: The position of the frame in the buffer pool.
+     * @param pid: The page id of the page stored in the frame.
+     */
+    virtual void insert(size_t frame, const PageId &pid) = 0;
+
+    /**
+     * @brief: Records an access to a frame that is already tracked.
+     * @param frame: The position of the frame in the buffer pool.
+     */
+    virtual void touch(size_t frame) = 0;
+
+    /**
+     * @brief: Stops tracking a frame.
+     * @param frame: The position of the frame in the buffer pool.
+     */
+    virtual void erase(size_t frame) = 0;
+
+    /**
+     * @brief: Stops tracking a frame whose page was evicted to make room for another page.
+     * @param frame: The position of the frame in the buffer pool.
+     * @note Unlike erase, this is where a policy may remember the history of the evicted page.
+     */
+    virtual void evicted(size_t frame) { erase(frame); }
+
+    /**
+     * @brief: Returns the frame that should be evicted next.
+     * @param evictable: Returns whether a frame may be evicted (i.e. it is not pinned).
+     * @throws std::runtime_error if no tracked frame is evictable.
+     * @note The frame is still tracked until it is evicted or erased. The BufferPool may fail to claim it (if it is
+     * pinned meanwhile) and ask for another victim, so this method must not record the eviction.
+     */
+    virtual size_t victim(const std::function<bool(size_t)> &evictable) = 0;
+
+    /**
+     * @brief: Returns the tracked frames, the next victims first.
+     * @note This method does not change the replacement state.
+     */
+    virtual std::vector<size_t> order() const = 0;
+};
+
+/**
+ * @brief Least recently used replacement backed by a linked list.
+ */
+class LruReplacer : public Replacer {
+    std::list<size_t> lru_list;
+    std::unordered_map<size_t, std::list<size_t>::iterator> pos_to_lru;
+
+public:
+    void insert(size_t frame, const PageId &pid) override;
+
+    void touch(size_t frame) override;
+
+    void erase(size_t frame) override;
+
+    size_t victim(const std::function<bool(size_t)> &evictable) override;
+
+    std::vector<size_t> order() const override;
+};
+
+/**
+ * @brief CLOCK (second chance) replacement backed by flat per-frame arrays.
+ * @details An access only sets the reference bit of the frame. The clock hand clears reference bits until it finds a
+ * frame whose bit is not set, which makes eviction an amortized O(1) sweep.
+ */
+class ClockReplacer : public Replacer {
+    std::vector<uint8_t> referenced;
+    std::vector<uint8_t> present;
+    size_t hand = 0;
+    size_t count = 0;
+
+public:
+    explicit ClockReplacer(size_t num_frames);
+
+    void insert(size_t frame, const PageId &pid) override;
+
+    void touch(size_t frame) override;
+
+    void erase(size_t frame) override;
+
+    size_t victim(const std::function<bool(size_t)> &evictable) override;
+
+    std::vector<size_t> order() const override;
+};
+
+/**
+ * @brief Simplified 2Q replacement.
+ * @details New pages enter the A1in FIFO queue and hits on them are ignored. Pages evicted from A1in are remembered in
+ * the A1out ghost queue (page ids only). A page that misses while it is in A1out is admitted to the Am LRU queue, which
+ * holds the hot pages. Victims are taken from A1in while it is larger than its share of the pool.
+ */
+class TwoQReplacer : public Replacer {
+    enum class queue_t : uint8_t {
+        NONE, A1IN, AM
+    };
+
+    size_t kin;
+    size_t kout;
+    std::list<size_t> a1in;
+    std::list<size_t> am;
+    std::list<PageId> a1out;
+    std::unordered_map<const PageId, std::list<PageId>::iterator> ghosts;
+    std::vector<queue_t> queue;
+    std::vector<std::list<size_t>::iterator> positions;
+    std::vector<PageId> pids;
+
+public:
+    explicit TwoQReplacer(size_t num_frames);
+
+    void insert(size_t frame, const PageId &pid) override;
+
+    void touch(size_t frame) override;
+
+    void erase(size_t frame) override;
+
+    void evicted(size_t frame) override;
+
+    size_t victim(const std::function<bool(size_t)> &evictable) override;
+
+    std::vector<size_t> order() const override;
+};
+
+/**
+ * @brief Creates a replacer for the specified policy.
+ * @param policy The replacement policy.
+ * @param num_frames The number of frames in the buffer pool.
+ */
+std::unique_ptr<Replacer> makeReplacer(replacement_t policy, size_t num_frames);
+
+} // namespace db
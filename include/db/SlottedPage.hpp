@@ -0,0 +1,104 @@
+#pragma once
+
+#include <db/DbFile.hpp>
+
+namespace db {
+struct SlottedPageHeader {
+  /// Number of entries in the slot directory, including the empty ones
+  uint16_t num_slots;
+
+  /// Number of tuples in the page
+  uint16_t num_tuples;
+
+  /// Number of bytes used by the records, which are packed at the end of the page
+  uint32_t record_bytes;
+};
+
+struct SlotEntry {
+  /// Offset of the record in the page (0 for an empty slot)
+  uint16_t offset;
+
+  /// Length of the record
+  uint16_t length;
+};
+
+/**
+ * @brief A heap page with a slot directory and variable-length records.
+ * @details The page starts with a SlottedPageHeader followed by the slot directory, which grows towards the end of the
+ * page. The records are serialized with TupleDesc::serialize_compact and packed at the end of the page, growing
+ * towards the directory. Deleting a record moves the records below it to close the gap, so the free space is always
+ * the contiguous range between the directory and the records. The slot of a deleted record stays in the directory
+ * (empty) so that the other slot numbers do not change; it is reused by a later insert. A zeroed page is empty.
+ * @note The interface is the one of HeapPage, so that a HeapFile can use either format.
+ */
+class SlottedPage {
+  const TupleDesc &td;
+  uint8_t *page;
+  SlottedPageHeader *header;
+  SlotEntry *slots;
+
+  /// Number of contiguous free bytes between the slot directory and the records
+  size_t freeSpace() const;
+
+public:
+  /**
+   * @brief Wrap a page with a slotted page.
+   * @param page The page to be wrapped.
+   * @param td The tuple descriptor of the page.
+   */
+  SlottedPage(Page &page, const TupleDesc &td);
+
+  /**
+   * @brief Get the first occupied slot of the page.
+   * @return The first occupied slot of the page, or end() if the page is empty.
+   */
+  size_t begin() const;
+
+  /**
+   * @brief Get the end of the page.
+   * @return The number of entries of the slot directory.
+   */
+  size_t end() const;
+
+  /**
+   * @brief Insert a tuple to the page.
+   * @details Reuse an empty slot if there is one, or else add a slot to the directory.
+   * @param t The tuple to be inserted.
+   * @return True if the tuple is inserted successfully, false if the page does not have enough free space.
+   */
+  bool insertTuple(const Tuple &t);
+
+  /**
+   * @brief Insert tuples to the page until one does not fit.
+   * @param tuples The tuples to be inserted, in order.
+   * @return The number of tuples inserted (a prefix of `tuples`).
+   */
+  size_t insertTuples(std::span<const Tuple> tuples);
+
+  /**
+   * @brief Delete a tuple from the page.
+   * @details Empty the slot of the tuple and compact the records to reclaim its space.
+   * @param slot The slot of the tuple to be deleted.
+   */
+  void deleteTuple(size_t slot);
+
+  /**
+   * @brief Check if the slot is occupied.
+   * @param slot The slot to be checked.
+   * @return True if the slot is empty, false otherwise.
+   */
+  bool empty(size_t slot) const;
+
+  /**
+   * @brief Get the tuple at the specified slot.
+   * @param slot The slot of the tuple to be deserialized.
+   * @return The tuple read from the page.
+   */
+  Tuple getTuple(size_t slot) const;
+
+  /**
+   * @brief Advance the slot to the next occupied slot, or to end().
+   */
+  void next(size_t &slot) const;
+};
+} // namespace db
@@ -90,6 +90,29 @@ namespace db {
          */
         Tuple deserialize(const uint8_t *data) const;
 
+        /**
+         * @brief Get the length of the compact serialization of a Tuple
+         * @details In the compact serialization, a CHAR field only takes a length byte and its characters (up to
+         * CHAR_SIZE, like in the fixed-width serialization), and fields are not aligned
+         * @param t the Tuple to serialize
+         * @return the number of bytes needed by serialize_compact
+         */
+        size_t compact_length(const Tuple &t) const;
+
+        /**
+         * @brief Serialize a Tuple in the compact, variable-length format
+         * @param data the buffer to serialize the Tuple into, of at least compact_length(t) bytes
+         * @param t the Tuple to serialize
+         */
+        void serialize_compact(uint8_t *data, const Tuple &t) const;
+
+        /**
+         * @brief Deserialize a Tuple serialized by serialize_compact
+         * @param data the buffer to deserialize the Tuple from
+         * @return the deserialized Tuple
+         */
+        Tuple deserialize_compact(const uint8_t *data) const;
+
         /**
          * @brief Merge two TupleDescs
          * @details The merged TupleDesc has all the fields of the two TupleDescs
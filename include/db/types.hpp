@@ -1,11 +1,14 @@
 #pragma once
 
 #include <array>
+#include <bit>
+#include <stdexcept>
 #include <string>
 #include <utility>
 #include <variant>
 #include <cstdint>
 #include <functional>
+#include <type_traits>
 
 namespace db {
     constexpr size_t INT_SIZE = sizeof(int);
@@ -18,15 +21,63 @@ namespace db {
 
     using field_t = std::variant<int, double, std::string>;
 
+    /// Compact identifier of a file interned by Database::add
+    using file_id_t = uint32_t;
+
+    constexpr file_id_t INVALID_FILE_ID = UINT32_MAX;
+
+    /**
+     * @brief Identifies a page as a (file id, page number) pair packed in 64 bits.
+     */
     struct PageId {
-        std::string file;
-        size_t page;
+        file_id_t file = INVALID_FILE_ID;
+        uint32_t page = 0;
 
     public:
+        PageId() = default;
+
+        /**
+         * @brief Constructs the page id of a page of a file.
+         * @throws std::out_of_range if the page number does not fit in 32 bits.
+         */
+        PageId(file_id_t file, size_t page) : file(file), page(checkPage(page)) {}
+
+        /**
+         * @brief Constructs the page id of a page of a file that was added to the Database.
+         * @throws std::out_of_range if no file with this name was ever added to the Database, or if the page number
+         * does not fit in 32 bits.
+         */
+        PageId(const std::string &file, size_t page);
+
+        uint64_t key() const { return static_cast<uint64_t>(file) << 32 | page; }
+
         bool operator==(const PageId &) const = default;
+
+        /**
+         * @brief Returns the page number as stored in a PageId.
+         * @throws std::out_of_range if it does not fit in 32 bits: it would alias another page.
+         */
+        static uint32_t checkPage(size_t page) {
+            if (page > UINT32_MAX) {
+                throw std::out_of_range("Page number out of range");
+            }
+            return static_cast<uint32_t>(page);
+        }
     };
 
-    constexpr size_t DEFAULT_PAGE_SIZE = 4096;
+    static_assert(sizeof(PageId) == sizeof(uint64_t) && std::is_trivially_copyable_v<PageId>);
+
+    // The page size is fixed per build (configure with -DDB_PAGE_SIZE=<bytes>) so that the capacity math of the page
+    // formats folds into constants.
+#ifndef DB_PAGE_SIZE
+#define DB_PAGE_SIZE 4096
+#endif
+
+    constexpr size_t DEFAULT_PAGE_SIZE = DB_PAGE_SIZE;
+
+    // Slot counts and offsets inside a page are stored as uint16_t, which caps the page size at 64 KiB.
+    static_assert(std::has_single_bit(DEFAULT_PAGE_SIZE) && DEFAULT_PAGE_SIZE >= 512 && DEFAULT_PAGE_SIZE <= 65536,
+                  "DB_PAGE_SIZE must be a power of two between 512 and 65536");
 
     using Page = std::array<uint8_t, DEFAULT_PAGE_SIZE>;
 } // namespace db
@@ -34,6 +85,10 @@ namespace db {
 template<>
 struct std::hash<const db::PageId> {
     std::size_t operator()(const db::PageId &r) const {
-        return std::hash<std::string>()(r.file) ^ std::hash<size_t>()(r.page);
+        // splitmix64 finalizer: cheap and mixes the file id into the low bits
+        uint64_t x = r.key();
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
     }
 };
\ No newline at end of file
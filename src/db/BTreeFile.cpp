@@ -7,24 +7,25 @@
 
 using namespace db;
 
-BTreeFile::BTreeFile(const std::string &name, const TupleDesc &td, size_t key_index)
-    : DbFile(name, td), key_index(key_index) {}
+BTreeFile::BTreeFile(const std::string &name, const TupleDesc &td, size_t key_index, const DbFileOptions &options)
+    : DbFile(name, td, options), key_index(key_index) {}
 
 void BTreeFile::insertTuple(const Tuple &t) {
   std::vector<size_t> path;
   BufferPool &bufferPool = getDatabase().getBufferPool();
-  PageId pid{name, root_id};
+  PageId pid{file_id, root_id};
 
-  Page &root_page = bufferPool.getPage(pid);
-  IndexPage root(root_page);
+  // The pages are pinned while they are in use, so the pages fetched later cannot evict them
+  PageGuard root_guard = bufferPool.pin(pid);
+  IndexPage root(*root_guard);
   if (root.header->size == 0 && root.children[0] != 1) {
-    bufferPool.markDirty({name, root_id});
-    pid.page = numPages++;
+    root_guard.markDirty();
+    pid.page = allocatePage();
     root.children[0] = pid.page;
   } else {
     while (true) {
-      Page &page = bufferPool.getPage(pid);
-      IndexPage node(page);
+      PageGuard node_guard = pid.page == root_id ? PageGuard() : bufferPool.pin(pid);
+      IndexPage node(node_guard ? *node_guard : *root_guard);
       auto pos = std::lower_bound(node.keys, node.keys + node.header->size, std::get<int>(t.get_field(key_index)));
       auto slot = pos - node.keys;
       pid.page = node.children[slot];
@@ -35,56 +36,58 @@ void BTreeFile::insertTuple(const Tuple &t) {
     }
   }
 
-  Page &page = bufferPool.getPage(pid);
-  bufferPool.markDirty(pid);
-  LeafPage leaf(page, td, key_index);
+  PageGuard leaf_guard = bufferPool.pin(pid);
+  leaf_guard.markDirty();
+  LeafPage leaf(*leaf_guard, td, key_index);
   if (!leaf.insertTuple(t)) {
     return;
   }
 
-  pid.page = numPages++;
-  Page &new_leaf_page = bufferPool.getPage(pid);
-  bufferPool.markDirty(pid);
-  LeafPage new_leaf(new_leaf_page, td, key_index);
+  pid.page = allocatePage();
+  PageGuard new_leaf_guard = bufferPool.pin(pid);
+  new_leaf_guard.markDirty();
+  LeafPage new_leaf(*new_leaf_guard, td, key_index);
   int new_key = leaf.split(new_leaf);
   leaf.header->next_leaf = pid.page;
   size_t new_child = pid.page;
+  leaf_guard.release();
+  new_leaf_guard.release();
 
   while (!path.empty()) {
     size_t parent_id = path.back();
     path.pop_back();
     pid.page = parent_id;
-    Page &parent_page = bufferPool.getPage(pid);
-    bufferPool.markDirty(pid);
-    IndexPage parent(parent_page);
+    PageGuard parent_guard = bufferPool.pin(pid);
+    parent_guard.markDirty();
+    IndexPage parent(*parent_guard);
     if (!parent.insert(new_key, new_child)) {
       return;
     }
 
-    pid.page = numPages++;
-    Page &new_internal_page = bufferPool.getPage(pid);
-    bufferPool.markDirty(pid);
-    IndexPage new_internal(new_internal_page);
+    pid.page = allocatePage();
+    PageGuard new_internal_guard = bufferPool.pin(pid);
+    new_internal_guard.markDirty();
+    IndexPage new_internal(*new_internal_guard);
     new_key = parent.split(new_internal);
     new_child = pid.page;
   }
 
-  bufferPool.markDirty({name, root_id});
+  root_guard.markDirty();
   if (!root.insert(new_key, new_child)) {
     return;
   }
-  pid.page = numPages++;
-  Page &new_child1 = bufferPool.getPage(pid);
-  bufferPool.markDirty(pid);
+  pid.page = allocatePage();
+  PageGuard child1_guard = bufferPool.pin(pid);
+  child1_guard.markDirty();
   size_t child1 = pid.page;
-  new_child1 = root_page;
-  IndexPage child1_page(new_child1);
+  *child1_guard = *root_guard;
+  IndexPage child1_page(*child1_guard);
 
-  pid.page = numPages++;
-  Page &new_child2 = bufferPool.getPage(pid);
-  bufferPool.markDirty(pid);
+  pid.page = allocatePage();
+  PageGuard child2_guard = bufferPool.pin(pid);
+  child2_guard.markDirty();
   size_t child2 = pid.page;
-  IndexPage child2_page(new_child2);
+  IndexPage child2_page(*child2_guard);
 
   int key = child1_page.split(child2_page);
   root.header->size = 1;
@@ -99,17 +102,15 @@ void BTreeFile::deleteTuple(const Iterator &it) {
 
 Tuple BTreeFile::getTuple(const Iterator &it) const {
   BufferPool &bufferPool = getDatabase().getBufferPool();
-  PageId pid{name, it.page};
-  Page &page = bufferPool.getPage(pid);
-  LeafPage leaf(page, td, key_index);
+  PageGuard guard = bufferPool.pin({file_id, it.page});
+  LeafPage leaf(*guard, td, key_index);
   return leaf.getTuple(it.slot);
 }
 
 void BTreeFile::next(Iterator &it) const {
   BufferPool &bufferPool = getDatabase().getBufferPool();
-  PageId pid{name, it.page};
-  Page &page = bufferPool.getPage(pid);
-  LeafPage leaf(page, td, key_index);
+  PageGuard guard = bufferPool.pin({file_id, it.page});
+  LeafPage leaf(*guard, td, key_index);
   if (it.slot + 1 < leaf.header->size) {
     it.slot++;
   } else {
@@ -120,10 +121,10 @@ void BTreeFile::next(Iterator &it) const {
 
 Iterator BTreeFile::begin() const {
   BufferPool &bufferPool = getDatabase().getBufferPool();
-  PageId pid{name, root_id};
+  PageId pid{file_id, root_id};
   while (true) {
-    Page &page = bufferPool.getPage(pid);
-    IndexPage node(page);
+    PageGuard guard = bufferPool.pin(pid);
+    IndexPage node(*guard);
     pid.page = node.children[0];
     if (!node.header->index_children) {
       break;
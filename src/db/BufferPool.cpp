@@ -1,106 +1,919 @@
 #include <db/BufferPool.hpp>
+#include <algorithm>
+#include <bit>
+#include <climits>
+#include <cmath>
 #include <db/Database.hpp>
+#include <memory>
 #include <numeric>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <unistd.h>
 
 using namespace db;
 
-BufferPool::BufferPool() : available(DEFAULT_NUM_PAGES) {
+static Page *mapArena(size_t size, huge_pages_t huge_pages) {
+    void *arena = MAP_FAILED;
+#ifdef MAP_HUGETLB
+    if (huge_pages == huge_pages_t::EXPLICIT) {
+        // Huge pages are aligned to their (larger) size
+        arena = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    }
+#endif
+    if (arena == MAP_FAILED) {
+        // mmap only aligns to the system page size: map the slack needed to align the start to DEFAULT_PAGE_SIZE, and
+        // unmap it again at both ends
+        auto system_page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        size_t slack = DEFAULT_PAGE_SIZE > system_page ? DEFAULT_PAGE_SIZE - system_page : 0;
+        void *mapped = mmap(nullptr, size + slack, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mapped == MAP_FAILED) {
+            throw std::runtime_error("mmap");
+        }
+        auto *start = static_cast<uint8_t *>(mapped);
+        size_t head = (DEFAULT_PAGE_SIZE - reinterpret_cast<uintptr_t>(start) % DEFAULT_PAGE_SIZE) % DEFAULT_PAGE_SIZE;
+        if (head != 0) {
+            munmap(start, head);
+        }
+        if (slack != head) {
+            munmap(start + head + size, slack - head);
+        }
+        arena = start + head;
+#ifdef MADV_HUGEPAGE
+        if (huge_pages != huge_pages_t::NONE) {
+            // Only a hint: the kernel may not have transparent huge pages enabled
+            madvise(arena, size, MADV_HUGEPAGE);
+        }
+#endif
+    }
+    auto *pages = static_cast<Page *>(arena);
+    std::uninitialized_default_construct_n(pages, size / sizeof(Page));
+    return pages;
+}
+
+BufferPool::BufferPool() : BufferPool(BufferPoolOptions{}) {}
+
+BufferPool::BufferPool(const BufferPoolOptions &options)
+        : num_pages(options.num_pages), pos_to_pid(std::make_unique<std::atomic<PageId>[]>(options.num_pages)),
+          pins(std::make_unique<std::atomic<uint32_t>[]>(options.num_pages)),
+          touched(std::make_unique<std::atomic<bool>[]>(options.num_pages)),
+          frame_hits(std::make_unique<std::atomic<size_t>[]>(options.num_pages)),
+          frame_latches(std::make_unique<std::shared_mutex[]>(options.num_pages)),
+          dirty_versions(std::make_unique<uint64_t[]>(options.num_pages)), num_shards(options.num_shards),
+          scan_ring_pages(options.scan_ring_pages), clean_target(options.clean_target),
+          writer_pages_per_second(options.writer_pages_per_second), writer_interval(options.writer_interval),
+          readahead_max_pages(options.readahead_max_pages), io_queue_depth(options.io_queue_depth) {
     // TODO pa0
-    std::iota(available.rbegin(), available.rend(), 0);
+    if (num_pages == 0) {
+        throw std::invalid_argument("BufferPool needs at least one page");
+    }
+    if (num_shards == 0 || num_shards > num_pages) {
+        throw std::invalid_argument("BufferPool needs between one shard and one shard per page");
+    }
+    if (clean_target < 0 || clean_target > 1) {
+        throw std::invalid_argument("The clean target must be between 0 and 1");
+    }
+    if (io_queue_depth == 0) {
+        throw std::invalid_argument("The I/O queue depth must be positive");
+    }
+    arena_size = num_pages * sizeof(Page);
+    if (options.huge_pages != huge_pages_t::NONE) {
+        arena_size = (arena_size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+    }
+    pages = mapArena(arena_size, options.huge_pages);
+
+    // Spread the frames evenly: the first (num_pages % num_shards) shards get one extra frame
+    shards = std::make_unique<Shard[]>(num_shards);
+    size_t first = 0;
+    for (size_t i = 0; i < num_shards; i++) {
+        Shard &shard = shards[i];
+        size_t count = num_pages / num_shards + (i < num_pages % num_shards ? 1 : 0);
+        shard.first = first;
+        shard.count = count;
+        shard.available.resize(count);
+        std::iota(shard.available.rbegin(), shard.available.rend(), first);
+        shard.table = std::make_unique<PageTable>(count);
+        shard.replacer = makeReplacer(options.replacement, count);
+        shard.touch_slots = std::bit_ceil(count);
+        shard.touches = std::make_unique<std::atomic<uint64_t>[]>(shard.touch_slots);
+        shard.io = makeIoBackend(options.io_backend, io_queue_depth);
+        first += count;
+    }
+
+    if (clean_target > 0 && writer_pages_per_second > 0) {
+        writer = std::thread(&BufferPool::backgroundWriter, this);
+    }
+    if (readahead_max_pages > 0) {
+        stream_sets = std::make_unique<StreamSet[]>(READAHEAD_STREAM_SETS);
+        for (size_t i = 0; i < READAHEAD_STREAM_SETS; i++) {
+            for (std::atomic<uint64_t> &key: stream_sets[i].next_keys) {
+                key.store(PageId{}.key(), std::memory_order_relaxed);
+            }
+        }
+        prefetcher = std::thread(&BufferPool::prefetchPages, this);
+    }
 }
 
 BufferPool::~BufferPool() {
     // TODO pa0
-    for (const size_t &pos: dirty) {
-        const Page &page = pages[pos];
-        const PageId &pid = pos_to_pid[pos];
-        getDatabase().get(pid.file).writePage(page, pid.page);
+    {
+        std::scoped_lock lock(writer_mutex, readahead_mutex);
+        stopping = true;
+    }
+    writer_cv.notify_one();
+    readahead_cv.notify_one();
+    if (writer.joinable()) {
+        writer.join();
+    }
+    if (prefetcher.joinable()) {
+        prefetcher.join();
+    }
+    try {
+        flushAll();
+    } catch (const std::exception &) {
+        // A destructor cannot report the error: the pages that could not be written are lost
+    }
+    munmap(pages, arena_size);
+}
+
+BufferPool::Shard &BufferPool::shardOf(const PageId &pid) const {
+    return shards[num_shards == 1 ? 0 : std::hash<const PageId>()(pid) % num_shards];
+}
+
+void BufferPool::flush(Shard &shard, size_t pos) {
+    if (!shard.dirty.contains(pos))
+        return;
+    // The page stays dirty if the write throws
+    PageId pid = pos_to_pid[pos].load(std::memory_order_relaxed);
+    getDatabase().get(pid.file).writePage(pages[pos], pid.page);
+    shard.dirty.erase(pos);
+    shard.stats.writebacks++;
+}
+
+/**
+ * @brief Returns the number of bytes a request transfers if it completes in full.
+ */
+static size_t requestBytes(const IoRequest &request) {
+    if (request.iov == nullptr) {
+        return request.length;
+    }
+    size_t bytes = 0;
+    for (unsigned i = 0; i < request.iovcnt; i++) {
+        bytes += request.iov[i].iov_len;
+    }
+    return bytes;
+}
+
+void BufferPool::runRequests(std::span<IoRequest> requests, std::span<Shard *const> request_shards) {
+    // Group the requests by shard: each group is run on the backend of its shard, in batches of io_queue_depth
+    std::vector<size_t> order(requests.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return request_shards[a] < request_shards[b];
+    });
+    std::vector<IoRequest> group;
+    for (size_t begin = 0, end; begin < order.size(); begin = end) {
+        Shard &shard = *request_shards[order[begin]];
+        group.clear();
+        for (end = begin; end < order.size() && request_shards[order[end]] == &shard; end++) {
+            group.push_back(requests[order[end]]);
+        }
+        {
+            std::lock_guard io_lock(shard.io_latch);
+            for (size_t i = 0; i < group.size(); i += io_queue_depth) {
+                shard.io->run(std::span(group).subspan(i, std::min<size_t>(io_queue_depth, group.size() - i)));
+            }
+        }
+        for (size_t i = begin; i < end; i++) {
+            requests[order[i]].result = group[i - begin].result;
+        }
+    }
+}
+
+void BufferPool::flushDirty(file_id_t file) {
+    struct DirtyFrame {
+        PageId pid;
+        size_t pos;
+        uint64_t version;
+        Shard *shard;
+    };
+    // Collect the dirty pages of every shard, so that a run of consecutive pages is merged even if its pages hash to
+    // different shards. The frames are pinned instead of keeping the shard latches during the writes
+    std::vector<DirtyFrame> frames;
+    for (size_t i = 0; i < num_shards; i++) {
+        Shard &shard = shards[i];
+        std::lock_guard lock(shard.latch);
+        for (size_t pos: shard.dirty) {
+            PageId pid = pos_to_pid[pos].load(std::memory_order_relaxed);
+            if (file == INVALID_FILE_ID || pid.file == file) {
+                pins[pos].fetch_add(1, std::memory_order_relaxed);
+                frames.push_back({pid, pos, dirty_versions[pos], &shard});
+            }
+        }
+    }
+    std::sort(frames.begin(), frames.end(), [](const DirtyFrame &a, const DirtyFrame &b) {
+        return a.pid.key() < b.pid.key();
+    });
+
+    bool failed = false;
+    try {
+        // Write in (file, page) order and merge runs of consecutive pages of a file into one vectored write
+        std::vector<iovec> iovs(frames.size());
+        std::vector<IoRequest> requests;
+        std::vector<Shard *> request_shards;
+        // Request r writes the pages of frames[request_begin[r]] and the next requests[r].iovcnt - 1 frames
+        std::vector<size_t> request_begin;
+        for (size_t i = 0, begin = 0; i < frames.size(); i++) {
+            iovs[i] = {pages[frames[i].pos].data(), DEFAULT_PAGE_SIZE};
+            bool last = i + 1 == frames.size() || i + 1 - begin == IOV_MAX ||
+                        frames[i + 1].pid.key() != frames[i].pid.key() + 1;
+            if (!last) {
+                continue;
+            }
+            const DbFile &db_file = getDatabase().get(frames[begin].pid.file);
+            if (db_file.isCompressed()) {
+                // Compressed pages have variable sizes and locations: they are written one at a time
+                for (size_t j = begin; j <= i; j++) {
+                    std::lock_guard lock(frames[j].shard->latch);
+                    flush(*frames[j].shard, frames[j].pos);
+                }
+            } else {
+                request_begin.push_back(begin);
+                request_shards.push_back(frames[begin].shard);
+                requests.push_back(db_file.writeRequest(std::span(iovs).subspan(begin, i + 1 - begin),
+                                                        frames[begin].pid.page));
+            }
+            begin = i + 1;
+        }
+        runRequests(requests, request_shards);
+        // A page is only clean once its whole request was written: a failed or short write leaves its pages dirty
+        for (size_t r = 0; r < requests.size(); r++) {
+            if (requests[r].result < 0 || static_cast<size_t>(requests[r].result) != requestBytes(requests[r])) {
+                failed = true;
+                continue;
+            }
+            for (size_t i = request_begin[r]; i < request_begin[r] + requests[r].iovcnt; i++) {
+                const DirtyFrame &frame = frames[i];
+                std::lock_guard lock(frame.shard->latch);
+                if (dirty_versions[frame.pos] == frame.version && frame.shard->dirty.erase(frame.pos) != 0) {
+                    frame.shard->stats.writebacks++;
+                }
+            }
+        }
+    } catch (...) {
+        for (const DirtyFrame &frame: frames) {
+            unpin(frame.pos);
+        }
+        throw;
+    }
+    for (const DirtyFrame &frame: frames) {
+        unpin(frame.pos);
+    }
+    if (failed) {
+        throw std::runtime_error("pwritev");
+    }
+}
+
+bool BufferPool::claim(size_t pos) {
+    uint32_t unpinned = 0;
+    return pins[pos].compare_exchange_strong(unpinned, EVICTING, std::memory_order_acquire);
+}
+
+void BufferPool::discard(Shard &shard, size_t pos, bool evicted) {
+    // The frame was claimed: no pin can be taken until its count is reset below
+    shard.table->erase(pos_to_pid[pos].load(std::memory_order_relaxed));
+    pos_to_pid[pos].store({}, std::memory_order_relaxed);
+
+    if (evicted) {
+        shard.replacer->evicted(pos - shard.first);
+    } else {
+        shard.replacer->erase(pos - shard.first);
+    }
+    shard.dirty.erase(pos);
+    shard.available.push_back(pos);
+    pins[pos].store(0, std::memory_order_release);
+}
+
+void BufferPool::evict(Shard &shard, size_t pos) {
+    // The frame was claimed: if its page cannot be written, the claim is dropped (the page stays resident and dirty)
+    // before the error propagates, or no one could pin or evict the frame again
+    try {
+        flush(shard, pos);
+    } catch (...) {
+        pins[pos].store(0, std::memory_order_release);
+        throw;
+    }
+    discard(shard, pos, true);
+}
+
+void BufferPool::backgroundWriter() {
+    // The budget is counted in thousandths of a page, so that a rate below one page per wakeup still writes
+    const size_t credit_per_wakeup = writer_pages_per_second * static_cast<size_t>(writer_interval.count());
+    size_t credit = 0;
+    std::unique_lock lock(writer_mutex);
+    while (!writer_cv.wait_for(lock, writer_interval, [this] { return stopping; })) {
+        lock.unlock();
+        credit += credit_per_wakeup;
+        size_t budget = credit / 1000;
+        // Only the fraction carries over: a budget left unused because the pool is clean is not saved up
+        credit %= 1000;
+        for (size_t i = 0; i < num_shards && budget > 0; i++) {
+            budget -= cleanShard(shards[i], budget);
+        }
+        lock.lock();
+    }
+}
+
+size_t BufferPool::cleanShard(Shard &shard, size_t budget) {
+    struct Candidate {
+        PageId pid;
+        size_t pos;
+        uint64_t version;
+    };
+    std::vector<Candidate> candidates;
+    {
+        std::lock_guard lock(shard.latch);
+        auto target = static_cast<size_t>(std::ceil(clean_target * static_cast<double>(shard.count)));
+        size_t clean = shard.count - shard.dirty.size();
+        if (clean >= target) {
+            return 0;
+        }
+        size_t needed = std::min(target - clean, budget);
+        if (writer_copies.size() < needed) {
+            writer_copies.resize(needed);
+        }
+        // Sweep the frames like a clock hand, at most one lap per wakeup. The pages are copied so that they can be
+        // written without the shard latch, and pinned so that they cannot be evicted (and written by the foreground)
+        // before the copy reaches the disk
+        for (size_t scanned = 0; scanned < shard.count && candidates.size() < needed; scanned++) {
+            size_t pos = shard.first + shard.sweep;
+            shard.sweep = (shard.sweep + 1) % shard.count;
+            if (pins[pos].load(std::memory_order_relaxed) != 0 || !shard.dirty.contains(pos) ||
+                !frame_latches[pos].try_lock_shared()) {
+                continue;
+            }
+            writer_copies[candidates.size()] = pages[pos];
+            frame_latches[pos].unlock_shared();
+            pins[pos].fetch_add(1, std::memory_order_relaxed);
+            candidates.push_back({pos_to_pid[pos].load(std::memory_order_relaxed), pos, dirty_versions[pos]});
+        }
+    }
+
+    std::vector<bool> succeeded(candidates.size());
+    for (size_t i = 0; i < candidates.size(); i++) {
+        try {
+            getDatabase().get(candidates[i].pid.file).writePage(writer_copies[i], candidates[i].pid.page);
+            succeeded[i] = true;
+        } catch (const std::exception &) {
+            // The file was removed or the write failed: the page stays dirty for the foreground to deal with
+        }
+    }
+
+    size_t written = 0;
+    std::lock_guard lock(shard.latch);
+    for (size_t i = 0; i < candidates.size(); i++) {
+        const Candidate &candidate = candidates[i];
+        // The shard latch keeps the frame from being evicted once it is unpinned
+        unpin(candidate.pos);
+        if (!succeeded[i]) {
+            continue;
+        }
+        if (dirty_versions[candidate.pos] != candidate.version) {
+            // The page was dirtied again after the copy: a flush may have written the newer page before the copy
+            // overwrote it, so it must be written again
+            shard.dirty.insert(candidate.pos);
+        } else if (shard.dirty.erase(candidate.pos) != 0) {
+            shard.stats.writebacks++;
+            shard.stats.background_writes++;
+            written++;
+        }
+    }
+    return written;
+}
+
+void BufferPool::noteAccess(const PageId &pid, bool miss) {
+    StreamSet &set = stream_sets[pid.file % READAHEAD_STREAM_SETS];
+    // Scans access the same page once per tuple, and other hits do not start streams: a hit only needs the latch if it
+    // reaches the page that continues a run
+    if (!miss && std::none_of(set.next_keys.begin(), set.next_keys.end(), [&pid](const std::atomic<uint64_t> &key) {
+            return key.load(std::memory_order_relaxed) == pid.key();
+        })) {
+        return;
+    }
+    std::unique_lock lock(set.latch);
+    set.accesses++;
+    size_t i = 0;
+    while (i < READAHEAD_STREAMS && !(set.streams[i].file == pid.file && set.streams[i].run > 0 &&
+                                      (set.streams[i].next == pid.page || set.streams[i].next == pid.page + 1))) {
+        i++;
+    }
+    if (i == READAHEAD_STREAMS) {
+        // Start a new stream in place of the least recently used one
+        i = std::min_element(set.streams.begin(), set.streams.end(), [](const Stream &a, const Stream &b) {
+            return a.last_access < b.last_access;
+        }) - set.streams.begin();
+        set.streams[i] = {pid.file, pid.page + 1, pid.page + 1, 0, 1, set.accesses};
+        set.next_keys[i].store(pid.key() + 1, std::memory_order_relaxed);
+        return;
+    }
+    Stream &stream = set.streams[i];
+    stream.last_access = set.accesses;
+    if (stream.next != pid.page) {
+        return;
+    }
+    stream.next = pid.page + 1;
+    set.next_keys[i].store(pid.key() + 1, std::memory_order_relaxed);
+    stream.run++;
+    stream.frontier = std::max(stream.frontier, stream.next);
+    if (stream.window == 0) {
+        stream.window = std::min(READAHEAD_MIN_PAGES, readahead_max_pages);
+    }
+    // Request the next window once less than half of the current one is ahead of the run
+    if (stream.frontier - stream.next >= stream.window / 2) {
+        return;
+    }
+    size_t file_pages;
+    try {
+        file_pages = getDatabase().get(pid.file).getNumPages();
+    } catch (const std::logic_error &) {
+        // The file was removed: read-ahead is only a hint, the access itself reports the error
+        return;
+    }
+    size_t last = std::min(stream.frontier + stream.window, file_pages);
+    size_t first = stream.frontier;
+    stream.frontier = std::max(stream.frontier, last);
+    stream.window = std::min(stream.window * 2, readahead_max_pages);
+    lock.unlock();
+    {
+        std::lock_guard queue_lock(readahead_mutex);
+        for (size_t page = first; page < last; page++) {
+            prefetch_queue.emplace_back(pid.file, page);
+        }
+    }
+    readahead_cv.notify_one();
+}
+
+void BufferPool::prefetchPages() {
+    std::unique_lock lock(readahead_mutex);
+    while (true) {
+        readahead_cv.wait(lock, [this] { return stopping || !prefetch_queue.empty(); });
+        if (stopping) {
+            return;
+        }
+        std::vector<PageId> batch;
+        while (!prefetch_queue.empty() && batch.size() < io_queue_depth) {
+            batch.push_back(prefetch_queue.front());
+            prefetch_queue.pop_front();
+        }
+        lock.unlock();
+        readAhead(batch);
+        lock.lock();
+    }
+}
+
+void BufferPool::readAhead(const std::vector<PageId> &batch) {
+    // Reserve a frame for every page that is not resident, keeping at least half of every shard for the foreground
+    std::vector<std::pair<PageId, size_t>> reserved;
+    std::vector<const DbFile *> files;
+    for (const PageId &pid: batch) {
+        Shard &shard = shardOf(pid);
+        std::lock_guard shard_lock(shard.latch);
+        if (shard.table->find(pid) != PageTable::NOT_FOUND || shard.loading.contains(pid) ||
+            shard.loading.size() >= std::max<size_t>(1, shard.count / 2)) {
+            continue;
+        }
+        try {
+            const DbFile &file = getDatabase().get(pid.file);
+            size_t pos = reserveFrame(shard);
+            shard.loading.insert(pid);
+            reserved.emplace_back(pid, pos);
+            files.push_back(&file);
+        } catch (const std::exception &) {
+            // Every frame is pinned or the file was removed: read-ahead is only a hint
+        }
+    }
+
+    // Read every run of consecutive pages of a file with one vectored read. Compressed pages are read (and
+    // decompressed) one at a time here instead
+    std::vector<iovec> iovs(reserved.size());
+    std::vector<IoRequest> requests;
+    std::vector<size_t> request_of(reserved.size(), SIZE_MAX);
+    std::vector<size_t> request_begin;
+    std::vector<bool> failed(reserved.size());
+    for (size_t i = 0, begin = 0; i < reserved.size(); i++) {
+        auto [pid, pos] = reserved[i];
+        if (files[i]->isCompressed()) {
+            try {
+                files[i]->readPage(pages[pos], pid.page);
+            } catch (const std::exception &) {
+                failed[i] = true;
+            }
+            begin = i + 1;
+            continue;
+        }
+        iovs[i] = {pages[pos].data(), DEFAULT_PAGE_SIZE};
+        request_of[i] = requests.size();
+        bool last = i + 1 == reserved.size() || i + 1 - begin == IOV_MAX ||
+                    reserved[i + 1].first.key() != pid.key() + 1;
+        if (last) {
+            request_begin.push_back(begin);
+            requests.push_back(files[begin]->readRequest(std::span(iovs).subspan(begin, i + 1 - begin),
+                                                         reserved[begin].first.page));
+            begin = i + 1;
+        }
+    }
+
+    std::vector<Shard *> request_shards;
+    for (size_t begin: request_begin) {
+        request_shards.push_back(&shardOf(reserved[begin].first));
+    }
+    runRequests(requests, request_shards);
+    // A short read (past the end of the file, or a partial vectored read) leaves the pages it did not reach zeroed:
+    // they are dropped rather than installed, and read again on a miss
+    for (size_t i = 0; i < reserved.size(); i++) {
+        if (request_of[i] != SIZE_MAX) {
+            ssize_t result = requests[request_of[i]].result;
+            size_t end = (i - request_begin[request_of[i]] + 1) * DEFAULT_PAGE_SIZE;
+            failed[i] = result < 0 || static_cast<size_t>(result) < end;
+        }
+    }
+
+    for (size_t i = 0; i < reserved.size(); i++) {
+        auto [pid, pos] = reserved[i];
+        Shard &shard = shardOf(pid);
+        std::lock_guard shard_lock(shard.latch);
+        // A miss on the page while it was read cancels the read-ahead: the copy read here may be stale by now
+        if (shard.loading.erase(pid) == 0 || failed[i]) {
+            shard.available.push_back(pos);
+            continue;
+        }
+        install(shard, pid, pos);
+        shard.stats.prefetches++;
     }
 }
 
+size_t BufferPool::lookup(Shard &shard, const PageId &pid, bool pin) {
+    size_t pos = shard.table->find(pid);
+    if (pos == PageTable::NOT_FOUND) {
+        return pos;
+    }
+    if (pin) {
+        uint32_t count = pins[pos].load(std::memory_order_relaxed);
+        do {
+            if (count & EVICTING) {
+                return PageTable::NOT_FOUND;
+            }
+        } while (!pins[pos].compare_exchange_weak(count, count + 1, std::memory_order_acquire));
+    }
+    // The frame may have been reused since the probe. Once pinned, it cannot change anymore
+    if (pos_to_pid[pos].load(std::memory_order_acquire) != pid) {
+        if (pin) {
+            pins[pos].fetch_sub(1, std::memory_order_release);
+        }
+        return PageTable::NOT_FOUND;
+    }
+    // Only the frame's own cache lines are written, unless the frame has to be queued: a frame that is already queued
+    // is touched once for all its hits
+    frame_hits[pos].fetch_add(1, std::memory_order_relaxed);
+    if (!touched[pos].load(std::memory_order_relaxed) && !touched[pos].exchange(true, std::memory_order_relaxed)) {
+        uint64_t ticket = shard.touch_head.fetch_add(1, std::memory_order_relaxed);
+        // The entry carries its ticket, so that the drain can tell it from the entry of the previous round
+        shard.touches[ticket % shard.touch_slots].store((ticket + 1) << 32 | (pos - shard.first),
+                                                        std::memory_order_release);
+    }
+    return pos;
+}
+
+void BufferPool::applyDeferredTouches(Shard &shard) const {
+    uint64_t head = shard.touch_head.load(std::memory_order_acquire);
+    for (; shard.touch_tail != head; shard.touch_tail++) {
+        uint64_t entry = shard.touches[shard.touch_tail % shard.touch_slots].load(std::memory_order_acquire);
+        if (entry >> 32 != ((shard.touch_tail + 1) & UINT32_MAX)) {
+            // The hit that took this ticket has not stored its frame yet: the next drain resumes here
+            break;
+        }
+        size_t pos = shard.first + (entry & UINT32_MAX);
+        touched[pos].store(false, std::memory_order_relaxed);
+        if (pos_to_pid[pos].load(std::memory_order_relaxed).file != INVALID_FILE_ID) {
+            shard.replacer->touch(pos - shard.first);
+        }
+    }
+}
+
+size_t BufferPool::fetch(Shard &shard, const PageId &pid) {
+    // The hits queued before this access are recorded first
+    applyDeferredTouches(shard);
+    // If already in buffer pool, record the access and return it
+    if (size_t pos = shard.table->find(pid); pos != PageTable::NOT_FOUND) {
+        shard.replacer->touch(pos - shard.first);
+        shard.stats.hits++;
+        return pos;
+    }
+    shard.stats.misses++;
+    auto start = std::chrono::steady_clock::now();
+    size_t pos = load(shard, pid);
+    shard.stats.miss_latency.record(std::chrono::steady_clock::now() - start);
+    return pos;
+}
+
+size_t BufferPool::reserveFrame(Shard &shard) {
+    // If there are no available pages, evict the victim of the replacement policy. If the page is dirty, flush it to disk
+    if (shard.available.empty()) {
+        applyDeferredTouches(shard);
+        // An optimistic pin may slip in between the choice of the victim and the claim: pick another one then
+        size_t pos;
+        do {
+            pos = shard.first + shard.replacer->victim([&](size_t frame) {
+                return pins[shard.first + frame].load(std::memory_order_relaxed) == 0;
+            });
+        } while (!claim(pos));
+        evict(shard, pos);
+        shard.stats.evictions++;
+    }
+
+    size_t pos = shard.available.back();
+    shard.available.pop_back();
+    return pos;
+}
+
+void BufferPool::install(Shard &shard, const PageId &pid, size_t pos) {
+    applyDeferredTouches(shard);
+    pos_to_pid[pos].store(pid, std::memory_order_relaxed);
+    shard.replacer->insert(pos - shard.first, pid);
+    // Publishing the page in the table makes the frame (and its contents) visible to optimistic lookups
+    shard.table->insert(pid, pos);
+}
+
+size_t BufferPool::load(Shard &shard, const PageId &pid) {
+    // Read the page from disk to one of the available slots and start tracking it
+    const DbFile &file = getDatabase().get(pid.file);
+    size_t pos = reserveFrame(shard);
+    shard.loading.erase(pid);
+    try {
+        file.readPage(pages[pos], pid.page);
+    } catch (...) {
+        shard.available.push_back(pos);
+        throw;
+    }
+    install(shard, pid, pos);
+    return pos;
+}
+
 Page &BufferPool::getPage(const PageId &pid) {
     // TODO pa0
-    // If already in buffer pool, make it the most recent page and return it
-    if (contains(pid)) {
-        size_t pos = pid_to_pos.at(pid);
-        lru_list.splice(lru_list.begin(), lru_list, pos_to_lru[pos]);
-        pos_to_lru[pos] = lru_list.begin();
+    Shard &shard = shardOf(pid);
+    size_t pos = lookup(shard, pid, false);
+    if (readahead_max_pages > 0) {
+        noteAccess(pid, pos == PageTable::NOT_FOUND);
+    }
+    if (pos != PageTable::NOT_FOUND) {
         return pages[pos];
     }
+    std::lock_guard lock(shard.latch);
+    return pages[fetch(shard, pid)];
+}
 
-    // If there are no available pages, evict the least recently used page. If the page is dirty, flush it to disk
-    if (available.empty()) {
-        size_t pos = lru_list.back();
-        const PageId &old_pid = pos_to_pid.at(pos);
-        if (isDirty(old_pid)) {
-            flushPage(old_pid);
-        }
-        discardPage(old_pid);
+PageGuard BufferPool::pin(const PageId &pid, latch_t mode, BufferRing *ring) {
+    Shard &shard = shardOf(pid);
+    // Free the frame of the oldest page of the ring before the miss, so that the page does not evict a page of the pool
+    bool join_ring = ring != nullptr && !contains(pid);
+    if (join_ring && ring->slots[ring->next].file != INVALID_FILE_ID) {
+        recycle(ring->slots[ring->next]);
+    }
+    size_t pos = join_ring ? PageTable::NOT_FOUND : lookup(shard, pid, true);
+    if (readahead_max_pages > 0) {
+        noteAccess(pid, pos == PageTable::NOT_FOUND);
+    }
+    if (pos == PageTable::NOT_FOUND) {
+        std::lock_guard lock(shard.latch);
+        pos = fetch(shard, pid);
+        pins[pos].fetch_add(1, std::memory_order_relaxed);
     }
+    if (join_ring) {
+        ring->slots[ring->next] = pid;
+        ring->next = (ring->next + 1) % ring->slots.size();
+    }
+    // The frame latch is acquired without the shard latch so that waiting for it does not block the shard
+    return {*this, pid, pos, mode};
+}
 
-    // Read the page from disk to one of the available slots, make it the most recent page
-    size_t pos = available.back();
-    available.pop_back();
+void BufferPool::recycle(const PageId &pid) {
+    Shard &shard = shardOf(pid);
+    std::lock_guard lock(shard.latch);
+    size_t pos = shard.table->find(pid);
+    // A page that is pinned by someone else is left to the replacement policy
+    if (pos == PageTable::NOT_FOUND || !claim(pos)) {
+        return;
+    }
+    evict(shard, pos);
+    shard.stats.recycled++;
+}
 
-    Page &page = pages[pos];
-    getDatabase().get(pid.file).readPage(page, pid.page);
-    pid_to_pos[pid] = pos;
-    pos_to_pid[pos] = pid;
+bool BufferPool::preload(const PageId &pid) {
+    Shard &shard = shardOf(pid);
+    std::lock_guard lock(shard.latch);
+    if (shard.table->find(pid) != PageTable::NOT_FOUND) {
+        return true;
+    }
+    if (shard.available.empty()) {
+        return false;
+    }
+    load(shard, pid);
+    shard.stats.prefetches++;
+    return true;
+}
 
-    lru_list.push_front(pos);
-    pos_to_lru[pos] = lru_list.begin();
+std::vector<PageId> BufferPool::residentPages() const {
+    std::vector<std::vector<PageId>> per_shard(num_shards);
+    size_t total = 0;
+    for (size_t i = 0; i < num_shards; i++) {
+        Shard &shard = shards[i];
+        std::lock_guard lock(shard.latch);
+        applyDeferredTouches(shard);
+        std::vector<size_t> order = shard.replacer->order();
+        // The replacer lists the next victims first
+        for (auto it = order.rbegin(); it != order.rend(); ++it) {
+            per_shard[i].push_back(pos_to_pid[shard.first + *it].load(std::memory_order_relaxed));
+        }
+        total += per_shard[i].size();
+    }
+    std::vector<PageId> resident;
+    resident.reserve(total);
+    for (size_t rank = 0; resident.size() < total; rank++) {
+        for (const std::vector<PageId> &pids: per_shard) {
+            if (rank < pids.size()) {
+                resident.push_back(pids[rank]);
+            }
+        }
+    }
+    return resident;
+}
 
-    return page;
+std::shared_ptr<BufferRing> BufferPool::makeScanRing(size_t file_pages) const {
+    if (scan_ring_pages == 0 || file_pages <= num_pages) {
+        return nullptr;
+    }
+    return std::make_shared<BufferRing>(scan_ring_pages);
 }
 
+void BufferPool::unpin(size_t pos) { pins[pos].fetch_sub(1, std::memory_order_release); }
+
 void BufferPool::markDirty(const PageId &pid) {
     // TODO pa0
-    size_t pos = pid_to_pos.at(pid);
-    dirty.insert(pos);
+    Shard &shard = shardOf(pid);
+    std::lock_guard lock(shard.latch);
+    size_t pos = shard.table->at(pid);
+    shard.dirty.insert(pos);
+    dirty_versions[pos]++;
 }
 
 bool BufferPool::isDirty(const PageId &pid) const {
     // TODO pa0
-    size_t pos = pid_to_pos.at(pid);
-    return dirty.contains(pos);
+    const Shard &shard = shardOf(pid);
+    std::lock_guard lock(shard.latch);
+    size_t pos = shard.table->at(pid);
+    return shard.dirty.contains(pos);
 }
 
 bool BufferPool::contains(const PageId &pid) const {
     // TODO pa0
-    return pid_to_pos.contains(pid);
+    return shardOf(pid).table->find(pid) != PageTable::NOT_FOUND;
 }
 
 void BufferPool::discardPage(const PageId &pid) {
     // TODO pa0
-    size_t pos = pid_to_pos.at(pid);
-    pid_to_pos.erase(pid);
-    pos_to_pid[pos] = {};
+    Shard &shard = shardOf(pid);
+    std::lock_guard lock(shard.latch);
+    size_t pos = shard.table->at(pid);
+    if (!claim(pos)) {
+        throw std::logic_error("Page is pinned");
+    }
+    discard(shard, pos);
+}
 
-    lru_list.erase(pos_to_lru[pos]);
-    pos_to_lru.erase(pos);
-    dirty.erase(pos);
-    available.push_back(pos);
+void BufferPool::discardFile(file_id_t file) {
+    for (size_t i = 0; i < num_shards; i++) {
+        Shard &shard = shards[i];
+        std::lock_guard lock(shard.latch);
+        std::erase_if(shard.loading, [file](const PageId &pid) { return pid.file == file; });
+        for (size_t pos = shard.first; pos < shard.first + shard.count; pos++) {
+            if (pos_to_pid[pos].load(std::memory_order_relaxed).file != file) {
+                continue;
+            }
+            if (!claim(pos)) {
+                throw std::logic_error("Page is pinned");
+            }
+            discard(shard, pos);
+        }
+    }
 }
 
 void BufferPool::flushPage(const PageId &pid) {
     // TODO pa0
-    size_t pos = pid_to_pos.at(pid);
-    if (dirty.erase(pos) == 0)
-        return;
-    const Page &page = pages[pos];
-    getDatabase().get(pid.file).writePage(page, pid.page);
+    Shard &shard = shardOf(pid);
+    std::lock_guard lock(shard.latch);
+    flush(shard, shard.table->at(pid));
 }
 
 void BufferPool::flushFile(const std::string &file) {
     // TODO pa0
-    std::vector<size_t> to_flush;
-    for (const size_t &pos: dirty) {
-        const PageId &pid = pos_to_pid[pos];
-        if (pid.file == file) {
-            to_flush.emplace_back(pid.page);
+    flushFile(getDatabase().getFileId(file));
+}
+
+void BufferPool::flushFile(file_id_t file) {
+    // flushDirty takes INVALID_FILE_ID for every file, but no page belongs to it
+    if (file != INVALID_FILE_ID) {
+        flushDirty(file);
+    }
+}
+
+void BufferPool::flushAll() { flushDirty(INVALID_FILE_ID); }
+
+size_t BufferPool::size() const { return num_pages; }
+
+size_t BufferPool::getNumShards() const { return num_shards; }
+
+BufferPoolStats BufferPool::getStats() const {
+    BufferPoolStats stats;
+    for (size_t i = 0; i < num_shards; i++) {
+        const Shard &shard = shards[i];
+        std::lock_guard lock(shard.latch);
+        stats.hits += shard.stats.hits;
+        for (size_t pos = shard.first; pos < shard.first + shard.count; pos++) {
+            stats.hits += frame_hits[pos].load(std::memory_order_relaxed);
+        }
+        stats.misses += shard.stats.misses;
+        stats.evictions += shard.stats.evictions;
+        stats.background_writes += shard.stats.background_writes;
+        stats.prefetches += shard.stats.prefetches;
+        stats.writebacks += shard.stats.writebacks;
+        stats.recycled += shard.stats.recycled;
+        stats.miss_latency += shard.stats.miss_latency;
+    }
+    return stats;
+}
+
+void BufferPool::resetStats() {
+    for (size_t i = 0; i < num_shards; i++) {
+        Shard &shard = shards[i];
+        std::lock_guard lock(shard.latch);
+        shard.stats = {};
+        for (size_t pos = shard.first; pos < shard.first + shard.count; pos++) {
+            frame_hits[pos].store(0, std::memory_order_relaxed);
         }
     }
-    for (const auto &page: to_flush) {
-        flushPage({file, page});
+}
+
+PageGuard::PageGuard(BufferPool &pool, const PageId &pid, size_t pos, latch_t mode)
+        : pool(&pool), pid(pid), page(&pool.pages[pos]), pos(pos), mode(mode) {
+    switch (mode) {
+        case latch_t::SHARED:
+            pool.frame_latches[pos].lock_shared();
+            break;
+        case latch_t::EXCLUSIVE:
+            pool.frame_latches[pos].lock();
+            break;
+        case latch_t::NONE:
+            break;
     }
+}
+
+PageGuard::~PageGuard() { release(); }
+
+PageGuard::PageGuard(PageGuard &&other) noexcept
+        : pool(std::exchange(other.pool, nullptr)), pid(other.pid), page(other.page), pos(other.pos), mode(other.mode) {}
+
+PageGuard &PageGuard::operator=(PageGuard &&other) noexcept {
+    if (this != &other) {
+        release();
+        pool = std::exchange(other.pool, nullptr);
+        pid = other.pid;
+        page = other.page;
+        pos = other.pos;
+        mode = other.mode;
+    }
+    return *this;
+}
+
+void PageGuard::markDirty() const { pool->markDirty(pid); }
+
+void PageGuard::release() {
+    if (pool == nullptr) {
+        return;
+    }
+    switch (mode) {
+        case latch_t::SHARED:
+            pool->frame_latches[pos].unlock_shared();
+            break;
+        case latch_t::EXCLUSIVE:
+            pool->frame_latches[pos].unlock();
+            break;
+        case latch_t::NONE:
+            break;
+    }
+    std::exchange(pool, nullptr)->unpin(pos);
+}
+
+double BufferPoolStats::hitRatio() const {
+    size_t accesses = hits + misses;
+    return accesses == 0 ? 0 : static_cast<double>(hits) / static_cast<double>(accesses);
 }
\ No newline at end of file
@@ -0,0 +1,145 @@
+#include <db/Compression.hpp>
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+using namespace db;
+
+static constexpr size_t MIN_MATCH = 4;
+static constexpr size_t MAX_OFFSET = UINT16_MAX;
+static constexpr size_t HASH_BITS = 12;
+
+static uint32_t load32(const uint8_t *p) {
+    uint32_t v;
+    std::memcpy(&v, p, sizeof v);
+    return v;
+}
+
+static size_t hash32(uint32_t v) { return (v * 2654435761u) >> (32 - HASH_BITS); }
+
+namespace {
+    /**
+     * @brief Bounds-checked output of the compressor.
+     */
+    struct Output {
+        std::span<uint8_t> dst;
+        size_t size = 0;
+        bool overflow = false;
+
+        void put(uint8_t byte) {
+            if (size == dst.size()) {
+                overflow = true;
+                return;
+            }
+            dst[size++] = byte;
+        }
+
+        // The part of a length that does not fit in its nibble, in bytes of up to 255
+        void putLength(size_t length) {
+            for (; length >= 255; length -= 255) {
+                put(255);
+            }
+            put(static_cast<uint8_t>(length));
+        }
+
+        void putBytes(const uint8_t *bytes, size_t count) {
+            if (dst.size() - size < count) {
+                overflow = true;
+                return;
+            }
+            std::memcpy(dst.data() + size, bytes, count);
+            size += count;
+        }
+
+        void putSequence(const uint8_t *literals, size_t num_literals, size_t offset, size_t match) {
+            size_t match_code = match == 0 ? 0 : match - MIN_MATCH;
+            put(static_cast<uint8_t>(std::min<size_t>(num_literals, 15) << 4 | std::min<size_t>(match_code, 15)));
+            if (num_literals >= 15) {
+                putLength(num_literals - 15);
+            }
+            putBytes(literals, num_literals);
+            if (match == 0) {
+                return;
+            }
+            put(static_cast<uint8_t>(offset));
+            put(static_cast<uint8_t>(offset >> 8));
+            if (match_code >= 15) {
+                putLength(match_code - 15);
+            }
+        }
+    };
+}
+
+size_t db::lzCompress(std::span<const uint8_t> src, std::span<uint8_t> dst) {
+    std::array<uint32_t, 1 << HASH_BITS> table{};
+    Output out{dst};
+    size_t anchor = 0;
+    size_t pos = 1;
+    while (pos + MIN_MATCH <= src.size() && !out.overflow) {
+        uint32_t sequence = load32(&src[pos]);
+        size_t candidate = std::exchange(table[hash32(sequence)], static_cast<uint32_t>(pos));
+        if (pos - candidate > MAX_OFFSET || load32(&src[candidate]) != sequence) {
+            pos++;
+            continue;
+        }
+        size_t match = MIN_MATCH;
+        while (pos + match < src.size() && src[candidate + match] == src[pos + match]) {
+            match++;
+        }
+        out.putSequence(&src[anchor], pos - anchor, pos - candidate, match);
+        pos += match;
+        anchor = pos;
+    }
+    out.putSequence(src.data() + anchor, src.size() - anchor, 0, 0);
+    return out.overflow ? 0 : out.size;
+}
+
+void db::lzDecompress(std::span<const uint8_t> src, std::span<uint8_t> dst) {
+    size_t in = 0;
+    size_t out = 0;
+    auto length = [&](size_t nibble) {
+        size_t length = nibble;
+        if (nibble == 15) {
+            uint8_t byte;
+            do {
+                if (in == src.size()) {
+                    throw std::runtime_error("Corrupt compressed block");
+                }
+                byte = src[in++];
+                length += byte;
+            } while (byte == 255);
+        }
+        return length;
+    };
+    while (in < src.size()) {
+        uint8_t token = src[in++];
+        size_t num_literals = length(token >> 4);
+        if (src.size() - in < num_literals || dst.size() - out < num_literals) {
+            throw std::runtime_error("Corrupt compressed block");
+        }
+        std::memcpy(dst.data() + out, src.data() + in, num_literals);
+        in += num_literals;
+        out += num_literals;
+        if (in == src.size()) {
+            break;
+        }
+        if (src.size() - in < 2) {
+            throw std::runtime_error("Corrupt compressed block");
+        }
+        size_t offset = src[in] | src[in + 1] << 8;
+        in += 2;
+        size_t match = length(token & 15) + MIN_MATCH;
+        if (offset == 0 || offset > out || dst.size() - out < match) {
+            throw std::runtime_error("Corrupt compressed block");
+        }
+        // The match may overlap the bytes it produces (a run), so it is copied byte by byte
+        for (size_t i = 0; i < match; i++, out++) {
+            dst[out] = dst[out - offset];
+        }
+    }
+    if (out != dst.size()) {
+        throw std::runtime_error("Corrupt compressed block");
+    }
+}
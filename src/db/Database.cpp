@@ -1,38 +1,163 @@
 #include <db/Database.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
 
 using namespace db;
 
-BufferPool &Database::getBufferPool() { return bufferPool; }
+Database::Database() : bufferPool(std::make_unique<BufferPool>()) {}
+
+Database::~Database() {
+    stopWarmup();
+    if (!warmup_path.empty()) {
+        try {
+            saveWarmupList(warmup_path);
+        } catch (const std::exception &) {
+            // The next start is only slower
+        }
+    }
+}
+
+BufferPool &Database::getBufferPool() { return *bufferPool; }
+
+void Database::configureBufferPool(const BufferPoolOptions &options) {
+    // The warm-up thread uses the current pool
+    stopWarmup();
+    bufferPool->flushAll();
+    bufferPool = std::make_unique<BufferPool>(options);
+}
 
 Database &db::getDatabase() {
     static Database instance;
     return instance;
 }
 
+PageId::PageId(const std::string &file, size_t page) : file(getDatabase().getFileId(file)), page(checkPage(page)) {}
+
 void Database::add(std::unique_ptr<DbFile> file) {
     // TODO pa0
     const std::string &name = file->getName();
-    if (files.contains(name)) {
-        // If a file with this name already exists, remove it first
-        // This handles the case where tests delete the physical file
-        // but the Database still has the old file object registered
-        bufferPool.flushFile(name);
-        files.erase(name);
+    std::unique_lock lock(latch);
+    auto [it, inserted] = ids.try_emplace(name, static_cast<file_id_t>(files.size()));
+    file_id_t id = it->second;
+    if (inserted) {
+        files.emplace_back();
+    } else if (files[id]) {
+        throw std::logic_error("File already exists");
     }
-    files[name] = std::move(file);
+    file->file_id = id;
+    files[id] = std::move(file);
 }
 
 std::unique_ptr<DbFile> Database::remove(const std::string &name) {
     // TODO pa0
-    auto nh = files.extract(name);
-    if (nh.empty()) {
+    file_id_t id;
+    {
+        std::shared_lock lock(latch);
+        auto it = ids.find(name);
+        if (it == ids.end() || !files[it->second]) {
+            throw std::logic_error("File does not exist");
+        }
+        id = it->second;
+    }
+    // The file id is reused by the next file added under this name: it must not find the pages of this one
+    bufferPool->flushFile(id);
+    bufferPool->discardFile(id);
+    std::unique_lock lock(latch);
+    if (!files[id]) {
         throw std::logic_error("File does not exist");
     }
-    Database::getBufferPool().flushFile(nh.key());
-    return std::move(nh.mapped());
+    return std::move(files[id]);
 }
 
 DbFile &Database::get(const std::string &name) const {
     // TODO pa0
-    return *files.at(name);
+    std::shared_lock lock(latch);
+    auto it = ids.find(name);
+    if (it == ids.end() || !files[it->second]) {
+        throw std::logic_error("File does not exist");
+    }
+    return *files[it->second];
+}
+
+DbFile &Database::get(file_id_t id) const {
+    std::shared_lock lock(latch);
+    if (id >= files.size() || !files[id]) {
+        throw std::logic_error("File does not exist");
+    }
+    return *files[id];
+}
+
+file_id_t Database::getFileId(const std::string &name) const {
+    std::shared_lock lock(latch);
+    return ids.at(name);
+}
+
+void Database::saveWarmupList(const std::string &path) const {
+    std::vector<PageId> resident = bufferPool->residentPages();
+    std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp);
+        for (const PageId &pid: resident) {
+            try {
+                // The name is last so that it may contain spaces
+                out << pid.page << ' ' << get(pid.file).getName() << '\n';
+            } catch (const std::logic_error &) {
+                // The file was removed
+            }
+        }
+        if (!out) {
+            throw std::runtime_error("Cannot write the warm-up list");
+        }
+    }
+    if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+        throw std::runtime_error("Cannot write the warm-up list");
+    }
+}
+
+void Database::startWarmup(const std::string &path) {
+    stopWarmup();
+    warmup_path = path;
+    warmup_loaded = 0;
+    warmup_stop = false;
+    warmup = std::thread(&Database::preload, this, path);
+}
+
+size_t Database::waitForWarmup() {
+    if (warmup.joinable()) {
+        warmup.join();
+    }
+    return warmup_loaded;
+}
+
+void Database::stopWarmup() {
+    warmup_stop = true;
+    waitForWarmup();
+}
+
+void Database::preload(std::string path) {
+    std::ifstream in(path);
+    std::vector<std::pair<std::string, size_t>> list;
+    size_t page;
+    std::string name;
+    // Only the most recently used pages that fit in the pool are worth reading
+    while (list.size() < bufferPool->size() && in >> page && std::getline(in >> std::ws, name)) {
+        list.emplace_back(std::move(name), page);
+    }
+    std::sort(list.begin(), list.end());
+    for (const auto &[file, id]: list) {
+        if (warmup_stop) {
+            return;
+        }
+        try {
+            PageId pid{getFileId(file), id};
+            // Throws if the name was interned but its file is not in the catalog anymore
+            get(pid.file);
+            if (bufferPool->preload(pid)) {
+                warmup_loaded++;
+            }
+        } catch (const std::exception &) {
+            // The file was not added (or was removed): skip its pages
+        }
+    }
 }
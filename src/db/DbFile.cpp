@@ -1,17 +1,78 @@
 #include <db/DbFile.hpp>
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
 #include <stdexcept>
+#include <vector>
 #include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
 using namespace db;
 
+/**
+ * @brief Returns whether the file accepts O_DIRECT transfers of page-aligned pages.
+ */
+static bool supportsDirectIo(int fd) {
+#ifdef STATX_DIOALIGN
+    struct statx stx{};
+    if (statx(fd, "", AT_EMPTY_PATH, STATX_DIOALIGN, &stx) == 0 && (stx.stx_mask & STATX_DIOALIGN)) {
+        // An offset alignment of 0 means that the filesystem does not support direct I/O
+        return stx.stx_dio_offset_align != 0 && DEFAULT_PAGE_SIZE % stx.stx_dio_offset_align == 0 &&
+               DEFAULT_PAGE_SIZE % stx.stx_dio_mem_align == 0;
+    }
+#endif
+    // Without alignment information, probe with an aligned read: some filesystems accept the flag but fail every read
+    std::unique_ptr<void, decltype(&std::free)> probe(std::aligned_alloc(DEFAULT_PAGE_SIZE, DEFAULT_PAGE_SIZE),
+                                                      &std::free);
+    return pread(fd, probe.get(), DEFAULT_PAGE_SIZE, 0) != -1;
+}
+
+static int adviceOf(access_t access) {
+    switch (access) {
+        case access_t::SEQUENTIAL:
+            return MADV_SEQUENTIAL;
+        case access_t::RANDOM:
+            return MADV_RANDOM;
+        default:
+            return MADV_NORMAL;
+    }
+}
+
 const TupleDesc &DbFile::getTupleDesc() const { return td; }
 
-DbFile::DbFile(const std::string &name, const TupleDesc &td) : name(name), td(td) {
+DbFile::DbFile(const std::string &name, const TupleDesc &td) : DbFile(name, td, DbFileOptions{}) {}
+
+DbFile::DbFile(const std::string &name, const TupleDesc &td, const DbFileOptions &options)
+    : extentPages(options.extent_pages), name(name), td(td) {
     // TODO pa1: open file and initialize numPages
     // Hint: use open, fstat
-    fd = open(name.c_str(), O_RDWR | O_CREAT, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    constexpr mode_t mode = S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH;
+    if (options.compression != compression_t::NONE && (options.mmap || options.direct_io)) {
+        throw std::invalid_argument("Compressed files cannot be mapped or use direct I/O");
+    }
+    fd = -1;
+    if (options.mmap) {
+        fd = open(name.c_str(), O_RDONLY);
+    } else if (options.direct_io) {
+        // tmpfs and some other filesystems reject O_DIRECT with EINVAL: use buffered I/O there
+        fd = open(name.c_str(), O_RDWR | O_CREAT | O_DIRECT, mode);
+        if (fd != -1) {
+            direct = true;
+            if (!supportsDirectIo(fd)) {
+                disableDirectIo();
+            }
+        }
+    }
+    if (fd == -1 && !options.mmap) {
+        fd = open(name.c_str(), O_RDWR | O_CREAT, mode);
+    }
     if (fd == -1) {
         throw std::runtime_error("open");
     }
@@ -20,6 +81,25 @@ DbFile::DbFile(const std::string &name, const TupleDesc &td) : name(name), td(td
         throw std::runtime_error("fstat");
     }
     numPages = st.st_size / DEFAULT_PAGE_SIZE;
+    mapped = options.mmap;
+    if (mapped && numPages != 0) {
+        void *addr = ::mmap(nullptr, numPages * DEFAULT_PAGE_SIZE, PROT_READ, MAP_SHARED, fd, 0);
+        if (addr == MAP_FAILED) {
+            close(fd);
+            throw std::runtime_error("mmap");
+        }
+        mapping = static_cast<const uint8_t *>(addr);
+        mappedPages = numPages;
+        advise(options.access);
+    }
+    // Blocks preallocated past the end of the file by a previous run count as reserved
+    allocatedPages = std::max<size_t>(numPages, st.st_blocks * 512 / DEFAULT_PAGE_SIZE);
+    if (options.compression != compression_t::NONE) {
+        // The pages are packed at the offsets chosen by the map: the file is not grown by extents
+        pageMap = std::make_unique<PageMap>(name + ".map");
+        numPages = allocatedPages = pageMap->size();
+        extentPages = 0;
+    }
     if (numPages == 0) {
         numPages = 1;
     }
@@ -28,32 +108,255 @@ DbFile::DbFile(const std::string &name, const TupleDesc &td) : name(name), td(td
 DbFile::~DbFile() {
     // TODO pa1: close file
     // Hind: use close
+    if (mapping) {
+        munmap(const_cast<uint8_t *>(mapping), mappedPages * DEFAULT_PAGE_SIZE);
+    }
+    // Truncating to the current size releases the space preallocated past the end of the file
+    struct stat st{};
+    if (!mapped && allocatedPages > numPages && fstat(fd, &st) == 0) {
+        ftruncate(fd, st.st_size);
+    }
     close(fd);
 }
 
 const std::string &DbFile::getName() const { return name; }
 
+file_id_t DbFile::getId() const { return file_id; }
+
+bool DbFile::isDirect() const { return direct; }
+
+bool DbFile::isMapped() const { return mapped; }
+
+bool DbFile::isCompressed() const { return pageMap != nullptr; }
+
+const Page &DbFile::mappedPage(const size_t id) const {
+    if (!mapped) {
+        throw std::logic_error("File is not mapped");
+    }
+    static const Page zeros{};
+    return id < mappedPages ? reinterpret_cast<const Page *>(mapping)[id] : zeros;
+}
+
+void DbFile::advise(access_t access) const {
+    if (!mapped) {
+        throw std::logic_error("File is not mapped");
+    }
+    // The hint is best effort: an empty file has no mapping to advise
+    if (mapping) {
+        madvise(const_cast<uint8_t *>(mapping), mappedPages * DEFAULT_PAGE_SIZE, adviceOf(access));
+    }
+}
+
+void DbFile::checkWritable() const {
+    if (mapped) {
+        throw std::logic_error("File is mapped read-only");
+    }
+}
+
+void DbFile::checkUncompressed() const {
+    if (pageMap) {
+        throw std::logic_error("Compressed pages cannot be transferred with an IoBackend");
+    }
+}
+
+void DbFile::readCompressed(Page &page, const size_t id) const {
+    PageExtent extent = pageMap->get(id);
+    metrics.recordRead(1, extent.length);
+    auto start = std::chrono::steady_clock::now();
+    if (extent.length == 0) {
+        page.fill(0);
+    } else if (extent.length == DEFAULT_PAGE_SIZE) {
+        if (pread(fd, page.data(), DEFAULT_PAGE_SIZE, static_cast<off_t>(extent.offset)) != DEFAULT_PAGE_SIZE) {
+            throw std::runtime_error("pread");
+        }
+    } else {
+        std::vector<uint8_t> compressed(extent.length);
+        if (pread(fd, compressed.data(), extent.length, static_cast<off_t>(extent.offset)) != static_cast<ssize_t>(extent.length)) {
+            throw std::runtime_error("pread");
+        }
+        lzDecompress(compressed, page);
+    }
+    metrics.recordReadLatency(std::chrono::steady_clock::now() - start);
+}
+
+void DbFile::writeCompressed(const Page &page, const size_t id) const {
+    auto start = std::chrono::steady_clock::now();
+    // A page that does not shrink is stored as is, so reading it back needs no decompression
+    std::array<uint8_t, DEFAULT_PAGE_SIZE - 1> compressed;
+    size_t length = lzCompress(page, compressed);
+    const uint8_t *data = length == 0 ? page.data() : compressed.data();
+    length = length == 0 ? DEFAULT_PAGE_SIZE : length;
+    metrics.recordWrite(1, length);
+    PageExtent extent = pageMap->place(id, static_cast<uint32_t>(length));
+    if (pwrite(fd, data, length, static_cast<off_t>(extent.offset)) != static_cast<ssize_t>(length)) {
+        throw std::runtime_error("pwrite");
+    }
+    metrics.recordWriteLatency(std::chrono::steady_clock::now() - start);
+}
+
+void DbFile::disableDirectIo() const {
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_DIRECT);
+    direct = false;
+}
+
+/**
+ * @brief An aligned copy of a page, used for direct I/O on a page that is not aligned.
+ */
+using BounceBuffer = std::unique_ptr<Page, decltype(&std::free)>;
+
+static BounceBuffer bounceBuffer(bool direct, const Page &page) {
+    if (!direct || reinterpret_cast<uintptr_t>(page.data()) % DEFAULT_PAGE_SIZE == 0) {
+        return {nullptr, &std::free};
+    }
+    return {static_cast<Page *>(std::aligned_alloc(DEFAULT_PAGE_SIZE, DEFAULT_PAGE_SIZE)), &std::free};
+}
+
 void DbFile::readPage(Page &page, const size_t id) const {
-    reads.push_back(id);
+    reads.push(id);
+    if (pageMap) {
+        readCompressed(page, id);
+        return;
+    }
+    metrics.recordRead(1, DEFAULT_PAGE_SIZE);
     // TODO pa1: read page
     // Hint: use pread
-    std::fill(page.begin(), page.end(), 0);
-    pread(fd, page.data(), DEFAULT_PAGE_SIZE, id * DEFAULT_PAGE_SIZE);
+    auto start = std::chrono::steady_clock::now();
+    if (mapped) {
+        page = mappedPage(id);
+        metrics.recordReadLatency(std::chrono::steady_clock::now() - start);
+        return;
+    }
+    BounceBuffer bounce = bounceBuffer(direct, page);
+    Page &target = bounce ? *bounce : page;
+    std::fill(target.begin(), target.end(), 0);
+    if (pread(fd, target.data(), DEFAULT_PAGE_SIZE, id * DEFAULT_PAGE_SIZE) == -1 && errno == EINVAL && direct) {
+        disableDirectIo();
+        pread(fd, target.data(), DEFAULT_PAGE_SIZE, id * DEFAULT_PAGE_SIZE);
+    }
+    if (bounce) {
+        page = *bounce;
+    }
+    metrics.recordReadLatency(std::chrono::steady_clock::now() - start);
+}
+
+void DbFile::readPages(const size_t first, std::span<Page *const> frames) const {
+    bool aligned = std::all_of(frames.begin(), frames.end(), [](const Page *frame) {
+        return reinterpret_cast<uintptr_t>(frame->data()) % DEFAULT_PAGE_SIZE == 0;
+    });
+    if (mapped || pageMap || (direct && !aligned)) {
+        for (size_t i = 0; i < frames.size(); i++) {
+            readPage(*frames[i], first + i);
+        }
+        return;
+    }
+    std::vector<iovec> iovs(std::min<size_t>(frames.size(), IOV_MAX));
+    for (size_t begin = 0; begin < frames.size(); begin += iovs.size()) {
+        size_t count = std::min(iovs.size(), frames.size() - begin);
+        for (size_t i = 0; i < count; i++) {
+            iovs[i] = {frames[begin + i]->data(), DEFAULT_PAGE_SIZE};
+        }
+        IoRequest request = readRequest(std::span(iovs).first(count), first + begin);
+        auto start = std::chrono::steady_clock::now();
+        if (preadv(fd, request.iov, static_cast<int>(count), request.offset) == -1 && errno == EINVAL && direct) {
+            disableDirectIo();
+            preadv(fd, request.iov, static_cast<int>(count), request.offset);
+        }
+        metrics.recordReadLatency(std::chrono::steady_clock::now() - start);
+    }
 }
 
 void DbFile::writePage(const Page &page, const size_t id) const {
-    writes.push_back(id);
+    checkWritable();
+    writes.push(id);
+    if (pageMap) {
+        writeCompressed(page, id);
+        return;
+    }
+    metrics.recordWrite(1, DEFAULT_PAGE_SIZE);
     // TODO pa1: write page
     // Hint: use pwrite
-    pwrite(fd, page.data(), DEFAULT_PAGE_SIZE, id * DEFAULT_PAGE_SIZE);
+    auto start = std::chrono::steady_clock::now();
+    BounceBuffer bounce = bounceBuffer(direct, page);
+    if (bounce) {
+        *bounce = page;
+    }
+    const Page &source = bounce ? *bounce : page;
+    ssize_t written = pwrite(fd, source.data(), DEFAULT_PAGE_SIZE, id * DEFAULT_PAGE_SIZE);
+    if (written == -1 && errno == EINVAL && direct) {
+        disableDirectIo();
+        written = pwrite(fd, source.data(), DEFAULT_PAGE_SIZE, id * DEFAULT_PAGE_SIZE);
+    }
+    metrics.recordWriteLatency(std::chrono::steady_clock::now() - start);
+    if (written != DEFAULT_PAGE_SIZE) {
+        throw std::runtime_error("pwrite");
+    }
+}
+
+IoRequest DbFile::readRequest(Page &page, const size_t id) const {
+    checkUncompressed();
+    reads.push(id);
+    metrics.recordRead(1, DEFAULT_PAGE_SIZE);
+    std::fill(page.begin(), page.end(), 0);
+    return {.fd = fd, .write = false, .buffer = page.data(), .length = DEFAULT_PAGE_SIZE,
+            .offset = static_cast<off_t>(id * DEFAULT_PAGE_SIZE)};
 }
 
-const std::vector<size_t> &DbFile::getReads() const { return reads; }
+IoRequest DbFile::readRequest(std::span<const iovec> pages, const size_t first) const {
+    checkUncompressed();
+    for (size_t i = 0; i < pages.size(); i++) {
+        reads.push(first + i);
+        std::memset(pages[i].iov_base, 0, pages[i].iov_len);
+    }
+    metrics.recordRead(pages.size(), pages.size() * DEFAULT_PAGE_SIZE);
+    return {.fd = fd, .write = false, .offset = static_cast<off_t>(first * DEFAULT_PAGE_SIZE), .iov = pages.data(),
+            .iovcnt = static_cast<unsigned>(pages.size())};
+}
 
-const std::vector<size_t> &DbFile::getWrites() const { return writes; }
+IoRequest DbFile::writeRequest(const Page &page, const size_t id) const {
+    checkWritable();
+    checkUncompressed();
+    writes.push(id);
+    metrics.recordWrite(1, DEFAULT_PAGE_SIZE);
+    return {.fd = fd, .write = true, .buffer = const_cast<uint8_t *>(page.data()), .length = DEFAULT_PAGE_SIZE,
+            .offset = static_cast<off_t>(id * DEFAULT_PAGE_SIZE)};
+}
+
+IoRequest DbFile::writeRequest(std::span<const iovec> pages, const size_t first) const {
+    checkWritable();
+    checkUncompressed();
+    for (size_t id = first; id < first + pages.size(); id++) {
+        writes.push(id);
+    }
+    metrics.recordWrite(pages.size(), pages.size() * DEFAULT_PAGE_SIZE);
+    return {.fd = fd, .write = true, .offset = static_cast<off_t>(first * DEFAULT_PAGE_SIZE), .iov = pages.data(),
+            .iovcnt = static_cast<unsigned>(pages.size())};
+}
+
+const TraceRing &DbFile::getReads() const { return reads; }
+
+const TraceRing &DbFile::getWrites() const { return writes; }
+
+void DbFile::setTraceCapacity(size_t capacity) {
+    reads.setCapacity(capacity);
+    writes.setCapacity(capacity);
+}
+
+IoStats DbFile::getIoStats() const { return metrics.snapshot(); }
+
+void DbFile::resetIoStats() {
+    metrics.reset();
+    reads.clear();
+    writes.clear();
+}
 
 void DbFile::insertTuple(const Tuple &t) { throw std::runtime_error("Not implemented"); }
 
+void DbFile::insertTuples(std::span<const Tuple> tuples) {
+    for (const Tuple &t: tuples) {
+        insertTuple(t);
+    }
+}
+
 void DbFile::deleteTuple(const Iterator &it) { throw std::runtime_error("Not implemented"); }
 
 Tuple DbFile::getTuple(const Iterator &it) const { throw std::runtime_error("Not implemented"); }
@@ -65,3 +368,36 @@ Iterator DbFile::begin() const { throw std::runtime_error("Not implemented"); }
 Iterator DbFile::end() const { throw std::runtime_error("Not implemented"); }
 
 size_t DbFile::getNumPages() const { return numPages; }
+
+size_t DbFile::getAllocatedPages() const { return allocatedPages; }
+
+size_t DbFile::allocatePage() {
+    checkWritable();
+    // The pages of a file are addressed by 32-bit PageIds
+    size_t page = PageId::checkPage(numPages);
+    numPages++;
+    if (numPages > allocatedPages && extentPages != 0) {
+        // Reserve whole extents so that the file grows in aligned, contiguous runs
+        size_t end = (numPages + extentPages - 1) / extentPages * extentPages;
+        if (fallocate(fd, FALLOC_FL_KEEP_SIZE, static_cast<off_t>(allocatedPages * DEFAULT_PAGE_SIZE),
+                      static_cast<off_t>((end - allocatedPages) * DEFAULT_PAGE_SIZE)) == 0) {
+            allocatedPages = end;
+        } else if (errno == EOPNOTSUPP) {
+            // The filesystem cannot preallocate: the file grows a page at a time
+            extentPages = 0;
+        }
+    }
+    allocatedPages = std::max(allocatedPages, numPages);
+    return page;
+}
+
+void DbFile::truncatePages(size_t pages) {
+    checkWritable();
+    if (pageMap) {
+        pageMap->truncate(pages);
+    } else if (ftruncate(fd, static_cast<off_t>(pages * DEFAULT_PAGE_SIZE)) == -1) {
+        throw std::runtime_error("ftruncate");
+    }
+    // Like a newly created file, an empty file still has a (blank) first page
+    numPages = allocatedPages = std::max<size_t>(pages, 1);
+}
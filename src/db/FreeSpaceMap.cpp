@@ -0,0 +1,130 @@
+#include <db/FreeSpaceMap.hpp>
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace db;
+
+/**
+ * @brief The header of the sidecar file, before the words of the bitmap.
+ */
+struct FreeSpaceMapHeader {
+    uint32_t magic;
+    uint32_t format;
+};
+
+static constexpr uint32_t FSM_MAGIC = 0x314d5346; // "FSM1"
+
+/**
+ * @brief Checks the header of a map, or writes one with `format` to an empty map if `create` is set.
+ */
+static void checkHeader(int fd, off_t size, uint32_t format, bool create) {
+    FreeSpaceMapHeader header{FSM_MAGIC, format};
+    if (size == 0) {
+        if (create && pwrite(fd, &header, sizeof header, 0) != sizeof header) {
+            throw std::runtime_error("pwrite");
+        }
+        return;
+    }
+    if (size < static_cast<off_t>(sizeof header) || pread(fd, &header, sizeof header, 0) != sizeof header ||
+        header.magic != FSM_MAGIC) {
+        throw std::runtime_error("Corrupt free-space map");
+    }
+    if (header.format != format) {
+        throw std::invalid_argument("File opened with another page format than it was created with");
+    }
+}
+
+FreeSpaceMap::FreeSpaceMap(const std::string &path, uint32_t format) {
+    fd = open(path.c_str(), O_RDWR | O_CREAT, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    if (fd == -1) {
+        throw std::runtime_error("open");
+    }
+    struct stat st{};
+    if (fstat(fd, &st) == -1) {
+        close(fd);
+        throw std::runtime_error("fstat");
+    }
+    try {
+        checkHeader(fd, st.st_size, format, true);
+    } catch (...) {
+        close(fd);
+        throw;
+    }
+    words.resize(std::max<off_t>(st.st_size - static_cast<off_t>(sizeof(FreeSpaceMapHeader)), 0) / sizeof(uint64_t));
+    auto bytes = static_cast<ssize_t>(words.size() * sizeof(uint64_t));
+    if (pread(fd, words.data(), bytes, sizeof(FreeSpaceMapHeader)) != bytes) {
+        close(fd);
+        throw std::runtime_error("pread");
+    }
+}
+
+void FreeSpaceMap::checkFormat(const std::string &path, uint32_t format) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1) {
+        return;
+    }
+    struct stat st{};
+    try {
+        if (fstat(fd, &st) == -1) {
+            throw std::runtime_error("fstat");
+        }
+        checkHeader(fd, st.st_size, format, false);
+    } catch (...) {
+        close(fd);
+        throw;
+    }
+    close(fd);
+}
+
+FreeSpaceMap::~FreeSpaceMap() { close(fd); }
+
+void FreeSpaceMap::store(size_t word) {
+    // The map is a hint: a lost update only delays the reuse of a page, or costs one check of a full page
+    auto offset = static_cast<off_t>(sizeof(FreeSpaceMapHeader) + word * sizeof(uint64_t));
+    pwrite(fd, &words[word], sizeof(uint64_t), offset);
+}
+
+size_t FreeSpaceMap::find() {
+    std::lock_guard lock(mutex);
+    for (; first < words.size(); first++) {
+        if (words[first] != 0) {
+            return first * 64 + std::countr_zero(words[first]);
+        }
+    }
+    return NONE;
+}
+
+void FreeSpaceMap::set(size_t page, bool free) {
+    std::lock_guard lock(mutex);
+    size_t word = page / 64;
+    uint64_t bit = uint64_t{1} << page % 64;
+    if (word >= words.size()) {
+        if (!free) {
+            return;
+        }
+        words.resize(word + 1);
+    }
+    if (((words[word] & bit) != 0) == free) {
+        return;
+    }
+    words[word] ^= bit;
+    if (free) {
+        first = std::min(first, word);
+    }
+    store(word);
+}
+
+void FreeSpaceMap::truncate(size_t pages) {
+    std::lock_guard lock(mutex);
+    words.resize(std::min(words.size(), (pages + 63) / 64));
+    if (pages % 64 != 0 && !words.empty() && words.size() == (pages + 63) / 64) {
+        words.back() &= (uint64_t{1} << pages % 64) - 1;
+        store(words.size() - 1);
+    }
+    first = std::min(first, words.size());
+    ftruncate(fd, static_cast<off_t>(sizeof(FreeSpaceMapHeader) + words.size() * sizeof(uint64_t)));
+}
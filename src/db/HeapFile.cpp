@@ -1,70 +1,235 @@
 #include <db/Database.hpp>
 #include <db/HeapFile.hpp>
 #include <db/HeapPage.hpp>
+#include <db/SlottedPage.hpp>
+#include <cstdio>
+#include <optional>
 #include <stdexcept>
+#include <vector>
+#include <sys/stat.h>
 
 using namespace db;
 
-HeapFile::HeapFile(const std::string &name, const TupleDesc &td) : DbFile(name, td) {}
+HeapFile::HeapFile(const std::string &name, const TupleDesc &td, const DbFileOptions &options)
+    : DbFile(name, td, options), layout(options.layout) {
+    // The free-space map records the layout the file was created with. A map left behind by a removed file of the
+    // same name describes pages that no longer exist: a new (empty) file starts a new map
+    auto format = static_cast<uint32_t>(layout);
+    std::string path = name + ".fsm";
+    struct stat st{};
+    if (stat(name.c_str(), &st) == 0 && st.st_size == 0) {
+        std::remove(path.c_str());
+    }
+    if (isMapped()) {
+        FreeSpaceMap::checkFormat(path, format);
+    } else {
+        fsm = std::make_unique<FreeSpaceMap>(path, format);
+    }
+}
+
+template<typename F>
+auto HeapFile::onPage(Page &page, F &&f) const {
+    if (layout == heap_layout_t::SLOTTED) {
+        SlottedPage sp(page, td);
+        return f(sp);
+    }
+    HeapPage hp(page, td);
+    return f(hp);
+}
+
+template<typename F>
+auto HeapFile::withPage(size_t page, BufferRing *ring, F &&f) const {
+    if (isMapped()) {
+        // The callers of withPage only read the page, so the read-only mapping is never written
+        return onPage(const_cast<Page &>(mappedPage(page)), f);
+    }
+    PageGuard guard = getDatabase().getBufferPool().pin({file_id, page}, latch_t::SHARED, ring);
+    return onPage(*guard, f);
+}
 
 void HeapFile::insertTuple(const Tuple &t) {
     // TODO pa1
     if (!td.compatible(t)) {
         throw std::runtime_error("Tuple not compatible with TupleDesc");
     }
+    if (isMapped()) {
+        throw std::logic_error("File is mapped read-only");
+    }
     BufferPool &bufferPool = getDatabase().getBufferPool();
-    PageId pid{name, 0};
+    // The map may be stale: a page it points to is checked, and unmarked if it turns out to be full
+    for (size_t page = fsm->find(); page != FreeSpaceMap::NONE; page = fsm->find()) {
+        if (page < numPages) {
+            PageGuard guard = bufferPool.pin({file_id, page}, latch_t::EXCLUSIVE);
+            if (onPage(*guard, [&t](auto &p) { return p.insertTuple(t); })) {
+                guard.markDirty();
+                return;
+            }
+        }
+        fsm->set(page, false);
+    }
+    PageId pid{file_id, 0};
     pid.page = numPages - 1;
-    Page &p = bufferPool.getPage(pid);
-    HeapPage hp(p, td);
-    if (!hp.insertTuple(t)) {
-        numPages++;
-        pid.page++;
-        Page &np = bufferPool.getPage(pid);
-        HeapPage nhp(np, td);
-        nhp.insertTuple(t);
-    }
-    bufferPool.markDirty(pid);
+    PageGuard guard = bufferPool.pin(pid, latch_t::EXCLUSIVE);
+    if (!onPage(*guard, [&t](auto &p) { return p.insertTuple(t); })) {
+        pid.page = allocatePage();
+        guard = bufferPool.pin(pid, latch_t::EXCLUSIVE);
+        onPage(*guard, [&t](auto &p) { return p.insertTuple(t); });
+    }
+    guard.markDirty();
+}
+
+/**
+ * @brief Checks every tuple before a bulk insert, so that a bad tuple does not leave the insert half done.
+ */
+static void checkCompatible(const TupleDesc &td, std::span<const Tuple> tuples) {
+    for (const Tuple &t: tuples) {
+        if (!td.compatible(t)) {
+            throw std::runtime_error("Tuple not compatible with TupleDesc");
+        }
+    }
+}
+
+bool HeapFile::fillPage(size_t page, std::span<const Tuple> &tuples) {
+    PageGuard guard = getDatabase().getBufferPool().pin({file_id, page}, latch_t::EXCLUSIVE);
+    size_t inserted = onPage(*guard, [tuples](auto &p) { return p.insertTuples(tuples); });
+    if (inserted != 0) {
+        guard.markDirty();
+    }
+    tuples = tuples.subspan(inserted);
+    return tuples.empty();
+}
+
+void HeapFile::insertTuples(std::span<const Tuple> tuples) {
+    checkCompatible(td, tuples);
+    if (isMapped()) {
+        throw std::logic_error("File is mapped read-only");
+    }
+    for (size_t page = fsm->find(); page != FreeSpaceMap::NONE && !tuples.empty(); page = fsm->find()) {
+        if (page < numPages && fillPage(page, tuples)) {
+            return;
+        }
+        fsm->set(page, false);
+    }
+    if (tuples.empty() || fillPage(numPages - 1, tuples)) {
+        return;
+    }
+    while (!fillPage(allocatePage(), tuples)) {
+    }
+}
+
+void HeapFile::appendTuples(std::span<const Tuple> tuples) {
+    checkCompatible(td, tuples);
+    if (isMapped()) {
+        throw std::logic_error("File is mapped read-only");
+    }
+    if (tuples.empty() || fillPage(numPages - 1, tuples)) {
+        return;
+    }
+    auto page = std::make_unique<Page>();
+    while (!tuples.empty()) {
+        page->fill(0);
+        tuples = tuples.subspan(onPage(*page, [tuples](auto &p) { return p.insertTuples(tuples); }));
+        writePage(*page, allocatePage());
+    }
+}
+
+size_t HeapFile::compact(size_t max_pages) {
+    if (isMapped()) {
+        throw std::logic_error("File is mapped read-only");
+    }
+    BufferPool &bufferPool = getDatabase().getBufferPool();
+    size_t pages = numPages;
+    for (size_t step = 0; step < max_pages && pages > 1; step++) {
+        size_t tail = pages - 1;
+        // The last page is latched while its tuples move, and they are deleted from it in the same step, so that no
+        // tuple is ever in the file twice
+        PageGuard guard = bufferPool.pin({file_id, tail}, latch_t::EXCLUSIVE);
+        std::vector<size_t> slots;
+        std::vector<Tuple> tuples;
+        onPage(*guard, [&slots, &tuples](const auto &p) {
+            for (size_t slot = p.begin(); slot != p.end(); p.next(slot)) {
+                slots.push_back(slot);
+                tuples.push_back(p.getTuple(slot));
+            }
+        });
+        std::span<const Tuple> rest(tuples);
+        for (size_t page = fsm->find(); page < tail && !rest.empty(); page = fsm->find()) {
+            if (!fillPage(page, rest)) {
+                fsm->set(page, false);
+            }
+        }
+        size_t moved = tuples.size() - rest.size();
+        if (moved != 0) {
+            onPage(*guard, [&slots, moved](auto &p) {
+                for (size_t i = 0; i < moved; i++) {
+                    p.deleteTuple(slots[i]);
+                }
+            });
+            guard.markDirty();
+            fsm->set(tail, true);
+        }
+        if (!rest.empty()) {
+            // The earlier pages are full: the last page keeps the tuples that did not fit
+            break;
+        }
+        pages--;
+    }
+    // The empty pages are dropped from the end of the file, down to the last one that is still pinned (by a reader,
+    // say): it and the pages before it stay in the file, empty, and are reused by later inserts
+    for (size_t page = numPages; page > pages; page--) {
+        PageId pid{file_id, page - 1};
+        try {
+            if (bufferPool.contains(pid)) {
+                bufferPool.discardPage(pid);
+            }
+        } catch (const std::logic_error &) {
+            pages = page;
+            break;
+        }
+    }
+    size_t reclaimed = numPages - pages;
+    if (reclaimed != 0) {
+        fsm->truncate(pages);
+        truncatePages(pages);
+    }
+    return reclaimed;
 }
 
 void HeapFile::deleteTuple(const Iterator &it) {
     // TODO pa1
+    if (isMapped()) {
+        throw std::logic_error("File is mapped read-only");
+    }
     BufferPool &bufferPool = getDatabase().getBufferPool();
-    PageId pid{name, it.page};
-    Page &p = bufferPool.getPage(pid);
-    HeapPage hp(p, td);
-    bufferPool.markDirty(pid);
-    hp.deleteTuple(it.slot);
+    PageGuard guard = bufferPool.pin({file_id, it.page}, latch_t::EXCLUSIVE);
+    guard.markDirty();
+    onPage(*guard, [&it](auto &p) { p.deleteTuple(it.slot); });
+    fsm->set(it.page, true);
 }
 
 Tuple HeapFile::getTuple(const Iterator &it) const {
     // TODO pa1
-    BufferPool &bufferPool = getDatabase().getBufferPool();
-    PageId pid{name, it.page};
-    Page &p = bufferPool.getPage(pid);
-    HeapPage hp(p, td);
-    return hp.getTuple(it.slot);
+    return withPage(it.page, it.ring.get(), [&it](const auto &p) { return p.getTuple(it.slot); });
 }
 
 void HeapFile::next(Iterator &it) const {
     // TODO pa1
-    BufferPool &bufferPool = getDatabase().getBufferPool();
     if (it.page < numPages) {
-        PageId pid{name, it.page};
-        Page &p = bufferPool.getPage(pid);
-        const HeapPage hp(p, td);
-        hp.next(it.slot);
-        if (it.slot != hp.end()) {
+        bool found = withPage(it.page, it.ring.get(), [&it](const auto &p) {
+            p.next(it.slot);
+            return it.slot != p.end();
+        });
+        if (found) {
             return;
         }
         it.page++;
     }
     while (it.page < numPages) {
-        PageId pid{name, it.page};
-        Page &p = bufferPool.getPage(pid);
-        const HeapPage hp(p, td);
-        it.slot = hp.begin();
-        if (it.slot != hp.end()) {
+        bool found = withPage(it.page, it.ring.get(), [&it](const auto &p) {
+            it.slot = p.begin();
+            return it.slot != p.end();
+        });
+        if (found) {
             return;
         }
         it.page++;
@@ -74,15 +239,17 @@ void HeapFile::next(Iterator &it) const {
 
 Iterator HeapFile::begin() const {
     // TODO pa1
-    BufferPool &bufferPool = getDatabase().getBufferPool();
+    // A scan of a file larger than the pool recycles a few frames instead of flushing the whole pool. A mapped file
+    // does not use the pool at all.
+    std::shared_ptr<BufferRing> ring = isMapped() ? nullptr : getDatabase().getBufferPool().makeScanRing(numPages);
     size_t page = 0;
     while (page < numPages) {
-        PageId pid{name, page};
-        Page &p = bufferPool.getPage(pid);
-        const HeapPage hp(p, td);
-        size_t slot = hp.begin();
-        if (slot != hp.end())
-            return {*this, page, slot};
+        std::optional<size_t> slot = withPage(page, ring.get(), [](const auto &p) -> std::optional<size_t> {
+            size_t slot = p.begin();
+            return slot != p.end() ? std::optional(slot) : std::nullopt;
+        });
+        if (slot)
+            return {*this, page, *slot, ring};
         page++;
     }
     return {*this, numPages, 0};
@@ -1,5 +1,8 @@
 #include <db/Database.hpp>
 #include <db/HeapPage.hpp>
+#include <algorithm>
+#include <bit>
+#include <cstring>
 #include <stdexcept>
 
 using namespace db;
@@ -12,16 +15,51 @@ HeapPage::HeapPage(Page &page, const TupleDesc &td) : td(td) {
     data = header + DEFAULT_PAGE_SIZE - td.length() * capacity;
 }
 
-size_t HeapPage::begin() const {
-    // TODO pa1
-    for (size_t i = 0; i < capacity; i++) {
-        if (!empty(i)) {
-            return i;
+/**
+ * @brief Load the header bits of 64 slots, starting with the first slot of a header byte.
+ * @details Slots are numbered from the most significant bit of each header byte, so a big-endian load puts the first
+ * slot in the most significant bit of the word and the slot order matches the bit order. Only the `size` bytes left in
+ * the header are read: the missing low bits are 0.
+ */
+static uint64_t loadSlots(const uint8_t *bytes, size_t size) {
+    uint64_t word = 0;
+    if (size >= sizeof word) {
+        std::memcpy(&word, bytes, sizeof word);
+    } else {
+        std::memcpy(&word, bytes, size);
+    }
+    if constexpr (std::endian::native == std::endian::little) {
+        word = __builtin_bswap64(word);
+    }
+    return word;
+}
+
+size_t HeapPage::find(size_t slot, bool occupied) const {
+    size_t header_size = (capacity + 7) / 8;
+    while (slot < capacity) {
+        // The last word is cut at the end of the header, and the slots past capacity are masked off
+        uint64_t word = loadSlots(header + slot / 8, header_size - slot / 8);
+        if (!occupied) {
+            word = ~word;
+        }
+        word <<= slot % 8;
+        size_t count = std::min<size_t>(64 - slot % 8, capacity - slot);
+        if (count < 64) {
+            word &= ~(UINT64_MAX >> count);
+        }
+        if (word != 0) {
+            return slot + std::countl_zero(word);
         }
+        slot += count;
     }
     return capacity;
 }
 
+size_t HeapPage::begin() const {
+    // TODO pa1
+    return find(0, true);
+}
+
 size_t HeapPage::end() const {
     // TODO pa1
     return capacity;
@@ -29,10 +67,7 @@ size_t HeapPage::end() const {
 
 bool HeapPage::insertTuple(const Tuple &t) {
     // TODO pa1
-    size_t slot = 0;
-    while (slot < capacity && (header[slot / 8] & (1 << (7 - slot % 8)))) {
-        slot++;
-    }
+    size_t slot = find(0, false);
     if (slot == capacity) {
         return false;
     }
@@ -42,6 +77,15 @@ bool HeapPage::insertTuple(const Tuple &t) {
     return true;
 }
 
+size_t HeapPage::insertTuples(std::span<const Tuple> tuples) {
+    size_t inserted = 0;
+    for (size_t slot = find(0, false); slot != capacity && inserted < tuples.size(); slot = find(slot + 1, false)) {
+        header[slot / 8] |= 1 << (7 - slot % 8);
+        td.serialize(data + slot * td.length(), tuples[inserted++]);
+    }
+    return inserted;
+}
+
 void HeapPage::deleteTuple(size_t slot) {
     // TODO pa1
     if (slot >= capacity) {
@@ -64,7 +108,7 @@ Tuple HeapPage::getTuple(size_t slot) const {
 
 void HeapPage::next(size_t &slot) const {
     // TODO pa1
-    while (++slot < capacity && empty(slot));
+    slot = find(slot + 1, true);
 }
 
 bool HeapPage::empty(size_t slot) const {
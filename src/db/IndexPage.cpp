@@ -4,7 +4,6 @@
 using namespace db;
 
 IndexPage::IndexPage(Page &page) {
-  capacity = (DEFAULT_PAGE_SIZE - sizeof(IndexPageHeader) - sizeof(int)) / (sizeof(int) + sizeof(size_t));
   header = reinterpret_cast<IndexPageHeader *>(page.data());
   keys = reinterpret_cast<int *>(header + 1);
   children = reinterpret_cast<size_t *>(keys + capacity + 1);
@@ -0,0 +1,213 @@
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <db/IoBackend.hpp>
+#include <initializer_list>
+#include <linux/io_uring.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <utility>
+
+using namespace db;
+
+void IoBackend::run(std::span<IoRequest> requests) {
+    std::vector<IoRequest *> batch;
+    batch.reserve(requests.size());
+    for (IoRequest &request: requests) {
+        batch.push_back(&request);
+    }
+    submit(batch);
+    size_t done = 0;
+    while (done < requests.size()) {
+        done += reap(requests.size() - done).size();
+    }
+}
+
+void SyncIoBackend::submit(std::span<IoRequest *const> requests) {
+    for (IoRequest *request: requests) {
+        ssize_t result;
+        if (request->iov != nullptr) {
+            int iovcnt = static_cast<int>(request->iovcnt);
+            result = request->write ? pwritev(request->fd, request->iov, iovcnt, request->offset)
+                                    : preadv(request->fd, request->iov, iovcnt, request->offset);
+        } else {
+            result = request->write ? pwrite(request->fd, request->buffer, request->length, request->offset)
+                                    : pread(request->fd, request->buffer, request->length, request->offset);
+        }
+        request->result = result < 0 ? -errno : result;
+        completed.push_back(request);
+    }
+}
+
+std::vector<IoRequest *> SyncIoBackend::reap(size_t) { return std::exchange(completed, {}); }
+
+size_t SyncIoBackend::inflight() const { return completed.size(); }
+
+UringIoBackend::UringIoBackend(unsigned queue_depth) {
+    io_uring_params params{};
+    ring_fd = static_cast<int>(syscall(__NR_io_uring_setup, queue_depth, &params));
+    if (ring_fd < 0) {
+        throw std::runtime_error("io_uring_setup");
+    }
+    entries = params.sq_entries;
+    sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap) {
+        sq_ring_size = cq_ring_size = std::max(sq_ring_size, cq_ring_size);
+    }
+    sq_ring = mmap(nullptr, sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd,
+                   IORING_OFF_SQ_RING);
+    cq_ring = single_mmap ? sq_ring : mmap(nullptr, cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                           ring_fd, IORING_OFF_CQ_RING);
+    sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+    sqes = mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+    if (sq_ring == MAP_FAILED || cq_ring == MAP_FAILED || sqes == MAP_FAILED) {
+        unmap();
+        throw std::runtime_error("mmap");
+    }
+
+    auto *sq = static_cast<uint8_t *>(sq_ring);
+    sq_head = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+    sq_tail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+    sq_mask = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+    sq_array = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+    auto *cq = static_cast<uint8_t *>(cq_ring);
+    cq_head = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+    cq_tail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+    cq_mask = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+    cqes = cq + params.cq_off.cqes;
+
+    // io_uring_setup may succeed on a kernel that lacks some of the operations used here
+    if (!supports({IORING_OP_READ, IORING_OP_WRITE, IORING_OP_READV, IORING_OP_WRITEV})) {
+        unmap();
+        throw std::runtime_error("io_uring operations not supported");
+    }
+}
+
+bool UringIoBackend::supports(std::initializer_list<uint8_t> ops) const {
+    constexpr unsigned num_ops = 256;
+    std::vector<uint8_t> buffer(sizeof(io_uring_probe) + num_ops * sizeof(io_uring_probe_op));
+    auto *probe = reinterpret_cast<io_uring_probe *>(buffer.data());
+    if (syscall(__NR_io_uring_register, ring_fd, IORING_REGISTER_PROBE, probe, num_ops) < 0) {
+        // The probe itself is newer than io_uring_setup
+        return false;
+    }
+    return std::all_of(ops.begin(), ops.end(), [probe](uint8_t op) {
+        return op <= probe->last_op && (probe->ops[op].flags & IO_URING_OP_SUPPORTED) != 0;
+    });
+}
+
+UringIoBackend::~UringIoBackend() {
+    // Requests still in the kernel reference caller buffers: wait for them before tearing the ring down
+    try {
+        reap(queued + in_kernel);
+    } catch (const std::exception &) {
+    }
+    unmap();
+}
+
+void UringIoBackend::unmap() {
+    if (sqes != nullptr && sqes != MAP_FAILED) {
+        munmap(sqes, sqes_size);
+    }
+    if (cq_ring != nullptr && cq_ring != MAP_FAILED && cq_ring != sq_ring) {
+        munmap(cq_ring, cq_ring_size);
+    }
+    if (sq_ring != nullptr && sq_ring != MAP_FAILED) {
+        munmap(sq_ring, sq_ring_size);
+    }
+    close(ring_fd);
+    sq_ring = cq_ring = sqes = nullptr;
+    ring_fd = -1;
+}
+
+void UringIoBackend::enter(unsigned to_submit, unsigned min_complete) {
+    unsigned flags = min_complete > 0 ? IORING_ENTER_GETEVENTS : 0;
+    long submitted;
+    do {
+        submitted = syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, nullptr, 0);
+    } while (submitted < 0 && errno == EINTR);
+    if (submitted < 0) {
+        throw std::runtime_error("io_uring_enter");
+    }
+    queued -= submitted;
+    in_kernel += submitted;
+}
+
+void UringIoBackend::drainCompletions() {
+    unsigned head = std::atomic_ref(*cq_head).load(std::memory_order_relaxed);
+    unsigned tail = std::atomic_ref(*cq_tail).load(std::memory_order_acquire);
+    for (; head != tail; head++) {
+        const io_uring_cqe &cqe = static_cast<const io_uring_cqe *>(cqes)[head & *cq_mask];
+        auto *request = reinterpret_cast<IoRequest *>(cqe.user_data);
+        request->result = cqe.res;
+        completed.push_back(request);
+        in_kernel--;
+    }
+    std::atomic_ref(*cq_head).store(head, std::memory_order_release);
+}
+
+void UringIoBackend::submit(std::span<IoRequest *const> requests) {
+    for (IoRequest *request: requests) {
+        // At most `entries` requests are in flight, so the completion queue cannot overflow
+        while (queued + in_kernel >= entries) {
+            if (queued > 0) {
+                enter(queued, 0);
+            } else {
+                enter(0, 1);
+                drainCompletions();
+            }
+        }
+        unsigned tail = std::atomic_ref(*sq_tail).load(std::memory_order_relaxed);
+        unsigned index = tail & *sq_mask;
+        io_uring_sqe &sqe = static_cast<io_uring_sqe *>(sqes)[index];
+        std::memset(&sqe, 0, sizeof(sqe));
+        sqe.fd = request->fd;
+        if (request->iov != nullptr) {
+            sqe.opcode = request->write ? IORING_OP_WRITEV : IORING_OP_READV;
+            sqe.addr = reinterpret_cast<uint64_t>(request->iov);
+            sqe.len = request->iovcnt;
+        } else {
+            sqe.opcode = request->write ? IORING_OP_WRITE : IORING_OP_READ;
+            sqe.addr = reinterpret_cast<uint64_t>(request->buffer);
+            sqe.len = static_cast<uint32_t>(request->length);
+        }
+        sqe.off = static_cast<uint64_t>(request->offset);
+        sqe.user_data = reinterpret_cast<uint64_t>(request);
+        sq_array[index] = index;
+        std::atomic_ref(*sq_tail).store(tail + 1, std::memory_order_release);
+        queued++;
+    }
+    if (queued > 0) {
+        enter(queued, 0);
+    }
+}
+
+std::vector<IoRequest *> UringIoBackend::reap(size_t min_complete) {
+    drainCompletions();
+    while (completed.size() < min_complete && queued + in_kernel > 0) {
+        if (queued > 0) {
+            enter(queued, 0);
+        }
+        enter(0, 1);
+        drainCompletions();
+    }
+    return std::exchange(completed, {});
+}
+
+size_t UringIoBackend::inflight() const { return queued + in_kernel + completed.size(); }
+
+std::unique_ptr<IoBackend> db::makeIoBackend(io_backend_t backend, unsigned queue_depth) {
+    if (backend == io_backend_t::IO_URING) {
+        try {
+            return std::make_unique<UringIoBackend>(queue_depth);
+        } catch (const std::runtime_error &) {
+            // io_uring is disabled (e.g. by seccomp) or the kernel is too old for io_uring or for its operations
+        }
+    }
+    return std::make_unique<SyncIoBackend>();
+}
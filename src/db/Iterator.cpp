@@ -3,7 +3,8 @@
 
 using namespace db;
 
-Iterator::Iterator(const DbFile &file, const size_t &page, size_t slot) : file(file), page(page), slot(slot) {}
+Iterator::Iterator(const DbFile &file, const size_t &page, size_t slot, std::shared_ptr<BufferRing> ring)
+        : file(file), page(page), slot(slot), ring(std::move(ring)) {}
 
 Tuple Iterator::operator*() const { return file.getTuple(*this); }
 
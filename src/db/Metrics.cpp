@@ -0,0 +1,148 @@
+#include <db/Metrics.hpp>
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <stdexcept>
+
+using namespace db;
+
+static size_t bucketOf(std::chrono::nanoseconds latency) {
+    auto ns = static_cast<uint64_t>(std::max<int64_t>(latency.count(), 0));
+    return std::min<size_t>(std::bit_width(ns), LATENCY_BUCKETS - 1);
+}
+
+void LatencyHistogram::record(std::chrono::nanoseconds latency) {
+    buckets[bucketOf(latency)]++;
+    count++;
+    total_ns += std::max<int64_t>(latency.count(), 0);
+}
+
+double LatencyHistogram::mean() const {
+    return count == 0 ? 0 : static_cast<double>(total_ns) / static_cast<double>(count);
+}
+
+uint64_t LatencyHistogram::percentile(double p) const {
+    if (count == 0) {
+        return 0;
+    }
+    auto rank = static_cast<uint64_t>(std::ceil(std::clamp(p, 0.0, 100.0) / 100 * static_cast<double>(count)));
+    uint64_t seen = 0;
+    for (size_t b = 0; b < LATENCY_BUCKETS; b++) {
+        seen += buckets[b];
+        if (seen >= std::max<uint64_t>(rank, 1)) {
+            return uint64_t{1} << b;
+        }
+    }
+    return uint64_t{1} << (LATENCY_BUCKETS - 1);
+}
+
+LatencyHistogram &LatencyHistogram::operator+=(const LatencyHistogram &other) {
+    for (size_t b = 0; b < LATENCY_BUCKETS; b++) {
+        buckets[b] += other.buckets[b];
+    }
+    count += other.count;
+    total_ns += other.total_ns;
+    return *this;
+}
+
+void AtomicLatencyHistogram::record(std::chrono::nanoseconds latency) {
+    buckets[bucketOf(latency)].fetch_add(1, std::memory_order_relaxed);
+    total_ns.fetch_add(std::max<int64_t>(latency.count(), 0), std::memory_order_relaxed);
+}
+
+LatencyHistogram AtomicLatencyHistogram::snapshot() const {
+    LatencyHistogram histogram;
+    for (size_t b = 0; b < LATENCY_BUCKETS; b++) {
+        histogram.buckets[b] = buckets[b].load(std::memory_order_relaxed);
+        histogram.count += histogram.buckets[b];
+    }
+    histogram.total_ns = total_ns.load(std::memory_order_relaxed);
+    return histogram;
+}
+
+void AtomicLatencyHistogram::reset() {
+    for (auto &bucket: buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    total_ns.store(0, std::memory_order_relaxed);
+}
+
+void IoMetrics::recordRead(size_t pages, size_t bytes) {
+    reads.fetch_add(pages, std::memory_order_relaxed);
+    read_requests.fetch_add(1, std::memory_order_relaxed);
+    bytes_read.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void IoMetrics::recordWrite(size_t pages, size_t bytes) {
+    writes.fetch_add(pages, std::memory_order_relaxed);
+    write_requests.fetch_add(1, std::memory_order_relaxed);
+    bytes_written.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void IoMetrics::recordReadLatency(std::chrono::nanoseconds latency) { read_latency.record(latency); }
+
+void IoMetrics::recordWriteLatency(std::chrono::nanoseconds latency) { write_latency.record(latency); }
+
+IoStats IoMetrics::snapshot() const {
+    return {reads.load(std::memory_order_relaxed), writes.load(std::memory_order_relaxed),
+            read_requests.load(std::memory_order_relaxed), write_requests.load(std::memory_order_relaxed),
+            bytes_read.load(std::memory_order_relaxed), bytes_written.load(std::memory_order_relaxed),
+            read_latency.snapshot(), write_latency.snapshot()};
+}
+
+void IoMetrics::reset() {
+    reads.store(0, std::memory_order_relaxed);
+    writes.store(0, std::memory_order_relaxed);
+    read_requests.store(0, std::memory_order_relaxed);
+    write_requests.store(0, std::memory_order_relaxed);
+    bytes_read.store(0, std::memory_order_relaxed);
+    bytes_written.store(0, std::memory_order_relaxed);
+    read_latency.reset();
+    write_latency.reset();
+}
+
+TraceRing::TraceRing(size_t capacity) {
+    setCapacity(capacity);
+}
+
+void TraceRing::push(size_t value) {
+    size_t i = recorded.fetch_add(1, std::memory_order_relaxed);
+    if (slots != 0) {
+        entries[i % slots].store(value, std::memory_order_relaxed);
+    }
+}
+
+size_t TraceRing::size() const {
+    return recorded.load(std::memory_order_relaxed);
+}
+
+size_t TraceRing::capacity() const {
+    return slots;
+}
+
+size_t TraceRing::operator[](size_t i) const {
+    size_t n = size();
+    if (i >= n || n - i > slots) {
+        throw std::out_of_range("Trace entry not retained");
+    }
+    return entries[i % slots].load(std::memory_order_relaxed);
+}
+
+std::vector<size_t> TraceRing::retained() const {
+    size_t n = size();
+    std::vector<size_t> values;
+    for (size_t i = n - std::min(n, slots); i < n; i++) {
+        values.push_back(entries[i % slots].load(std::memory_order_relaxed));
+    }
+    return values;
+}
+
+void TraceRing::clear() {
+    recorded.store(0, std::memory_order_relaxed);
+}
+
+void TraceRing::setCapacity(size_t capacity) {
+    entries = std::make_unique<std::atomic<size_t>[]>(capacity);
+    slots = capacity;
+    recorded.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,94 @@
+#include <db/PageMap.hpp>
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace db;
+
+PageMap::PageMap(const std::string &path) {
+    fd = open(path.c_str(), O_RDWR | O_CREAT, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    if (fd == -1) {
+        throw std::runtime_error("open");
+    }
+    struct stat st{};
+    if (fstat(fd, &st) == -1) {
+        close(fd);
+        throw std::runtime_error("fstat");
+    }
+    extents.resize(st.st_size / sizeof(PageExtent));
+    auto bytes = static_cast<ssize_t>(extents.size() * sizeof(PageExtent));
+    if (pread(fd, extents.data(), bytes, 0) != bytes) {
+        close(fd);
+        throw std::runtime_error("pread");
+    }
+
+    // The gaps between the slots in use are free
+    std::vector<PageExtent> used;
+    std::copy_if(extents.begin(), extents.end(), std::back_inserter(used),
+                 [](const PageExtent &extent) { return extent.capacity != 0; });
+    std::sort(used.begin(), used.end(), [](const PageExtent &a, const PageExtent &b) { return a.offset < b.offset; });
+    for (const PageExtent &extent: used) {
+        if (extent.offset > end) {
+            free_slots.emplace(extent.offset - end, end);
+        }
+        end = std::max(end, extent.offset + extent.capacity);
+    }
+}
+
+PageMap::~PageMap() { close(fd); }
+
+size_t PageMap::size() const {
+    std::lock_guard lock(mutex);
+    return extents.size();
+}
+
+PageExtent PageMap::get(size_t id) const {
+    std::lock_guard lock(mutex);
+    return id < extents.size() ? extents[id] : PageExtent{};
+}
+
+PageExtent PageMap::place(size_t id, uint32_t length) {
+    std::lock_guard lock(mutex);
+    if (id >= extents.size()) {
+        extents.resize(id + 1);
+    }
+    PageExtent &extent = extents[id];
+    if (length > extent.capacity) {
+        if (extent.capacity != 0) {
+            free_slots.emplace(extent.capacity, extent.offset);
+        }
+        auto capacity = static_cast<uint32_t>((length + PAGE_SLOT_ALIGNMENT - 1) / PAGE_SLOT_ALIGNMENT *
+                                              PAGE_SLOT_ALIGNMENT);
+        auto it = free_slots.lower_bound(capacity);
+        if (it != free_slots.end()) {
+            extent.offset = it->second;
+            extent.capacity = it->first;
+            free_slots.erase(it);
+        } else {
+            extent.offset = end;
+            extent.capacity = capacity;
+            end += capacity;
+        }
+    }
+    extent.length = length;
+    if (pwrite(fd, &extent, sizeof extent, static_cast<off_t>(id * sizeof extent)) != sizeof extent) {
+        throw std::runtime_error("pwrite");
+    }
+    return extent;
+}
+
+void PageMap::truncate(size_t pages) {
+    std::lock_guard lock(mutex);
+    for (size_t id = pages; id < extents.size(); id++) {
+        if (extents[id].capacity != 0) {
+            free_slots.emplace(extents[id].capacity, extents[id].offset);
+        }
+    }
+    extents.resize(std::min(pages, extents.size()));
+    if (ftruncate(fd, static_cast<off_t>(extents.size() * sizeof(PageExtent))) == -1) {
+        throw std::runtime_error("ftruncate");
+    }
+}
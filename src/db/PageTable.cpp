@@ -0,0 +1,112 @@
+#include <db/PageTable.hpp>
+#include <bit>
+#include <stdexcept>
+#include <thread>
+
+using namespace db;
+
+PageTable::PageTable(size_t max_entries) {
+    // A load factor of at most 1/2 keeps the probe sequences short and always leaves an empty slot to end them
+    size_t capacity = std::bit_ceil(std::max<size_t>(2 * max_entries, 8));
+    slots = std::make_unique<Slot[]>(capacity);
+    mask = capacity - 1;
+    shift = 64 - std::countr_zero(capacity);
+}
+
+size_t PageTable::home(uint64_t key) const {
+    // The shard of a page is picked from the low bits of the same hash: use the high bits here
+    return std::hash<const PageId>()({static_cast<file_id_t>(key >> 32), static_cast<uint32_t>(key)}) >> shift;
+}
+
+void PageTable::beginWrite() {
+    // An odd version marks a write in progress. The acquire keeps the slot updates after the increment
+    version.fetch_add(1, std::memory_order_acquire);
+}
+
+void PageTable::endWrite() { version.fetch_add(1, std::memory_order_release); }
+
+size_t PageTable::find(const PageId &pid) const {
+    uint64_t key = pid.key();
+    for (size_t attempt = 0;; attempt++) {
+        uint64_t before = version.load(std::memory_order_acquire);
+        if (before & 1) {
+            if (attempt % 64 == 63) {
+                std::this_thread::yield();
+            }
+            continue;
+        }
+        size_t result = NOT_FOUND;
+        for (size_t i = home(key);; i = (i + 1) & mask) {
+            uint64_t slot_key = slots[i].key.load(std::memory_order_acquire);
+            if (slot_key == key) {
+                result = slots[i].pos.load(std::memory_order_acquire);
+                break;
+            }
+            if (slot_key == EMPTY) {
+                break;
+            }
+        }
+        // The acquire loads above cannot move after this check
+        if (version.load(std::memory_order_relaxed) == before) {
+            return result;
+        }
+    }
+}
+
+size_t PageTable::at(const PageId &pid) const {
+    size_t pos = find(pid);
+    if (pos == NOT_FOUND) {
+        throw std::out_of_range("Page not in the page table");
+    }
+    return pos;
+}
+
+void PageTable::insert(const PageId &pid, size_t pos) {
+    if (2 * (count + 1) > mask + 1) {
+        throw std::length_error("Page table is full");
+    }
+    uint64_t key = pid.key();
+    size_t i = home(key);
+    while (slots[i].key.load(std::memory_order_relaxed) != EMPTY) {
+        i = (i + 1) & mask;
+    }
+    beginWrite();
+    slots[i].pos.store(pos, std::memory_order_release);
+    slots[i].key.store(key, std::memory_order_release);
+    count++;
+    endWrite();
+}
+
+bool PageTable::erase(const PageId &pid) {
+    uint64_t key = pid.key();
+    size_t i = home(key);
+    while (true) {
+        uint64_t slot_key = slots[i].key.load(std::memory_order_relaxed);
+        if (slot_key == key) {
+            break;
+        }
+        if (slot_key == EMPTY) {
+            return false;
+        }
+        i = (i + 1) & mask;
+    }
+    beginWrite();
+    // Shift back the following entries of the cluster that would no longer be reachable from their home slot
+    for (size_t j = (i + 1) & mask;; j = (j + 1) & mask) {
+        uint64_t moved = slots[j].key.load(std::memory_order_relaxed);
+        if (moved == EMPTY) {
+            break;
+        }
+        size_t h = home(moved);
+        bool reachable = i <= j ? (i < h && h <= j) : (i < h || h <= j);
+        if (!reachable) {
+            slots[i].pos.store(slots[j].pos.load(std::memory_order_relaxed), std::memory_order_release);
+            slots[i].key.store(moved, std::memory_order_release);
+            i = j;
+        }
+    }
+    slots[i].key.store(EMPTY, std::memory_order_release);
+    count--;
+    endWrite();
+    return true;
+}
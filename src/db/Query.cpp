@@ -105,8 +105,9 @@ void db::join(const DbFile &left, const DbFile &right, DbFile &out, const JoinPr
   size_t left_index = left_td.index_of(pred.left);
   size_t right_index = right_td.index_of(pred.right);
   for (auto it1 = left.begin(); it1 != left.end(); ++it1) {
+    // Read the outer tuple once instead of fetching its page again for every inner tuple
+    const auto &left_t = left.getTuple(it1);
     for (auto it2 = right.begin(); it2 != right.end(); ++it2) {
-      const auto &left_t = left.getTuple(it1);
       const auto &right_t = right.getTuple(it2);
       if (eval(left_t.get_field(left_index), right_t.get_field(right_index), pred.op)) {
         std::vector<field_t> fields;
@@ -0,0 +1,183 @@
+#include <algorithm>
+#include <db/Replacer.hpp>
+#include <optional>
+#include <stdexcept>
+
+using namespace db;
+
+void LruReplacer::insert(size_t frame, const PageId &) {
+    lru_list.push_front(frame);
+    pos_to_lru[frame] = lru_list.begin();
+}
+
+void LruReplacer::touch(size_t frame) {
+    lru_list.splice(lru_list.begin(), lru_list, pos_to_lru[frame]);
+    pos_to_lru[frame] = lru_list.begin();
+}
+
+void LruReplacer::erase(size_t frame) {
+    lru_list.erase(pos_to_lru[frame]);
+    pos_to_lru.erase(frame);
+}
+
+size_t LruReplacer::victim(const std::function<bool(size_t)> &evictable) {
+    for (auto it = lru_list.rbegin(); it != lru_list.rend(); ++it) {
+        if (evictable(*it)) {
+            return *it;
+        }
+    }
+    throw std::runtime_error("No frame to evict");
+}
+
+std::vector<size_t> LruReplacer::order() const { return {lru_list.rbegin(), lru_list.rend()}; }
+
+ClockReplacer::ClockReplacer(size_t num_frames) : referenced(num_frames), present(num_frames) {}
+
+void ClockReplacer::insert(size_t frame, const PageId &) {
+    present[frame] = 1;
+    referenced[frame] = 1;
+    count++;
+}
+
+void ClockReplacer::touch(size_t frame) { referenced[frame] = 1; }
+
+void ClockReplacer::erase(size_t frame) {
+    present[frame] = 0;
+    referenced[frame] = 0;
+    count--;
+}
+
+size_t ClockReplacer::victim(const std::function<bool(size_t)> &evictable) {
+    // Every evictable frame has its bit cleared within one revolution, so the sweep ends within two
+    for (size_t step = 0; count != 0 && step < 2 * present.size(); step++) {
+        size_t frame = hand;
+        hand = hand + 1 == present.size() ? 0 : hand + 1;
+        if (!present[frame] || !evictable(frame)) {
+            continue;
+        }
+        if (!referenced[frame]) {
+            return frame;
+        }
+        referenced[frame] = 0;
+    }
+    throw std::runtime_error("No frame to evict");
+}
+
+std::vector<size_t> ClockReplacer::order() const {
+    // The hand reaches the frames without a reference bit first
+    std::vector<size_t> frames;
+    frames.reserve(count);
+    for (uint8_t bit: {0, 1}) {
+        for (size_t i = 0; i < present.size(); i++) {
+            size_t frame = (hand + i) % present.size();
+            if (present[frame] && referenced[frame] == bit) {
+                frames.push_back(frame);
+            }
+        }
+    }
+    return frames;
+}
+
+TwoQReplacer::TwoQReplacer(size_t num_frames)
+        : kin(std::max<size_t>(num_frames / 4, 1)), kout(std::max<size_t>(num_frames / 2, 1)), queue(num_frames),
+          positions(num_frames), pids(num_frames) {}
+
+void TwoQReplacer::insert(size_t frame, const PageId &pid) {
+    pids[frame] = pid;
+    if (auto it = ghosts.find(pid); it != ghosts.end()) {
+        // The page was referenced again after it left A1in: it is hot
+        a1out.erase(it->second);
+        ghosts.erase(it);
+        am.push_front(frame);
+        positions[frame] = am.begin();
+        queue[frame] = queue_t::AM;
+        return;
+    }
+    a1in.push_front(frame);
+    positions[frame] = a1in.begin();
+    queue[frame] = queue_t::A1IN;
+}
+
+void TwoQReplacer::touch(size_t frame) {
+    // Hits in A1in are correlated references (e.g. the tuples of a page during a scan) and do not promote the page
+    if (queue[frame] == queue_t::AM) {
+        am.splice(am.begin(), am, positions[frame]);
+    }
+}
+
+void TwoQReplacer::erase(size_t frame) {
+    switch (queue[frame]) {
+        case queue_t::A1IN:
+            a1in.erase(positions[frame]);
+            break;
+        case queue_t::AM:
+            am.erase(positions[frame]);
+            break;
+        case queue_t::NONE:
+            return;
+    }
+    queue[frame] = queue_t::NONE;
+}
+
+void TwoQReplacer::evicted(size_t frame) {
+    if (queue[frame] == queue_t::A1IN) {
+        // Remember the page so that a new reference promotes it to Am
+        const PageId &pid = pids[frame];
+        if (!ghosts.contains(pid)) {
+            if (a1out.size() == kout) {
+                ghosts.erase(a1out.back());
+                a1out.pop_back();
+            }
+            a1out.push_front(pid);
+            ghosts[pid] = a1out.begin();
+        }
+    }
+    erase(frame);
+}
+
+static std::optional<size_t> oldest(const std::list<size_t> &queue, const std::function<bool(size_t)> &evictable) {
+    for (auto it = queue.rbegin(); it != queue.rend(); ++it) {
+        if (evictable(*it)) {
+            return *it;
+        }
+    }
+    return std::nullopt;
+}
+
+size_t TwoQReplacer::victim(const std::function<bool(size_t)> &evictable) {
+    std::optional<size_t> frame;
+    if (a1in.size() > kin) {
+        frame = oldest(a1in, evictable);
+    }
+    if (!frame) {
+        frame = oldest(am, evictable);
+    }
+    if (!frame) {
+        frame = oldest(a1in, evictable);
+    }
+    if (!frame) {
+        throw std::runtime_error("No frame to evict");
+    }
+    return *frame;
+}
+
+std::vector<size_t> TwoQReplacer::order() const {
+    // A1in is drained first only while it is above its share of the pool
+    const std::list<size_t> &first = a1in.size() > kin ? a1in : am;
+    const std::list<size_t> &second = a1in.size() > kin ? am : a1in;
+    std::vector<size_t> frames(first.rbegin(), first.rend());
+    frames.insert(frames.end(), second.rbegin(), second.rend());
+    return frames;
+}
+
+std::unique_ptr<Replacer> db::makeReplacer(replacement_t policy, size_t num_frames) {
+    switch (policy) {
+        case replacement_t::LRU:
+            return std::make_unique<LruReplacer>();
+        case replacement_t::CLOCK:
+            return std::make_unique<ClockReplacer>(num_frames);
+        case replacement_t::TWO_Q:
+            return std::make_unique<TwoQReplacer>(num_frames);
+    }
+    throw std::logic_error("Unknown replacement policy");
+}
@@ -0,0 +1,102 @@
+#include <db/SlottedPage.hpp>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+using namespace db;
+
+static_assert(sizeof(SlottedPageHeader) == 8 && sizeof(SlotEntry) == 4);
+
+SlottedPage::SlottedPage(Page &page, const TupleDesc &td) : td(td) {
+    this->page = page.data();
+    header = reinterpret_cast<SlottedPageHeader *>(page.data());
+    slots = reinterpret_cast<SlotEntry *>(header + 1);
+}
+
+size_t SlottedPage::freeSpace() const {
+    size_t directory = sizeof(SlottedPageHeader) + header->num_slots * sizeof(SlotEntry);
+    return DEFAULT_PAGE_SIZE - header->record_bytes - directory;
+}
+
+size_t SlottedPage::begin() const {
+    size_t slot = 0;
+    while (slot < header->num_slots && empty(slot)) {
+        slot++;
+    }
+    return slot;
+}
+
+size_t SlottedPage::end() const { return header->num_slots; }
+
+bool SlottedPage::insertTuple(const Tuple &t) {
+    // A record takes at least one byte, so that its offset stays inside the page
+    size_t length = std::max<size_t>(td.compact_length(t), 1);
+    bool reuse = header->num_tuples < header->num_slots;
+    if (freeSpace() < length + (reuse ? 0 : sizeof(SlotEntry))) {
+        return false;
+    }
+    size_t slot = header->num_slots;
+    if (reuse) {
+        slot = 0;
+        while (!empty(slot)) {
+            slot++;
+        }
+    } else {
+        header->num_slots++;
+    }
+    header->record_bytes += length;
+    header->num_tuples++;
+    slots[slot] = {static_cast<uint16_t>(DEFAULT_PAGE_SIZE - header->record_bytes), static_cast<uint16_t>(length)};
+    td.serialize_compact(page + slots[slot].offset, t);
+    return true;
+}
+
+size_t SlottedPage::insertTuples(std::span<const Tuple> tuples) {
+    size_t inserted = 0;
+    while (inserted < tuples.size() && insertTuple(tuples[inserted])) {
+        inserted++;
+    }
+    return inserted;
+}
+
+void SlottedPage::deleteTuple(size_t slot) {
+    if (slot >= header->num_slots) {
+        throw std::runtime_error("Out of index");
+    }
+    if (empty(slot)) {
+        throw std::runtime_error("Slot not occupied");
+    }
+    // Close the gap: the records below the deleted one move up by its length
+    SlotEntry deleted = slots[slot];
+    size_t low = DEFAULT_PAGE_SIZE - header->record_bytes;
+    std::memmove(page + low + deleted.length, page + low, deleted.offset - low);
+    for (size_t i = 0; i < header->num_slots; i++) {
+        if (slots[i].offset != 0 && slots[i].offset < deleted.offset) {
+            slots[i].offset += deleted.length;
+        }
+    }
+    header->record_bytes -= deleted.length;
+    header->num_tuples--;
+    slots[slot] = {0, 0};
+    // Empty slots at the end of the directory are dropped
+    while (header->num_slots > 0 && empty(header->num_slots - 1)) {
+        header->num_slots--;
+    }
+}
+
+bool SlottedPage::empty(size_t slot) const { return slot >= header->num_slots || slots[slot].offset == 0; }
+
+Tuple SlottedPage::getTuple(size_t slot) const {
+    if (empty(slot)) {
+        throw std::runtime_error("Slot not occupied");
+    }
+    return td.deserialize_compact(page + slots[slot].offset);
+}
+
+void SlottedPage::next(size_t &slot) const {
+    // The directory may have shrunk below the slot if its tuple was deleted
+    do {
+        slot++;
+    } while (slot < header->num_slots && empty(slot));
+    slot = std::min<size_t>(slot, header->num_slots);
+}
@@ -144,6 +144,85 @@ void TupleDesc::serialize(uint8_t *data, const Tuple &t) const {
     }
 }
 
+/**
+ * @brief The characters of a CHAR field that are stored: up to the first NUL and at most CHAR_SIZE.
+ */
+static size_t storedLength(const std::string &s) { return strnlen(s.c_str(), CHAR_SIZE); }
+
+static_assert(CHAR_SIZE <= UINT8_MAX, "The compact serialization stores the length of a CHAR field in one byte");
+
+size_t TupleDesc::compact_length(const Tuple &t) const {
+    size_t length = 0;
+    for (size_t i = 0; i < types.size(); i++) {
+        switch (types[i]) {
+            case type_t::INT:
+                length += INT_SIZE;
+                break;
+            case type_t::DOUBLE:
+                length += DOUBLE_SIZE;
+                break;
+            case type_t::CHAR:
+                length += 1 + storedLength(std::get<std::string>(t.get_field(i)));
+                break;
+        }
+    }
+    return length;
+}
+
+void TupleDesc::serialize_compact(uint8_t *data, const Tuple &t) const {
+    for (size_t i = 0; i < types.size(); i++) {
+        const field_t &field = t.get_field(i);
+        switch (types[i]) {
+            case type_t::INT:
+                std::memcpy(data, &std::get<int>(field), INT_SIZE);
+                data += INT_SIZE;
+                break;
+            case type_t::DOUBLE:
+                std::memcpy(data, &std::get<double>(field), DOUBLE_SIZE);
+                data += DOUBLE_SIZE;
+                break;
+            case type_t::CHAR: {
+                const std::string &s = std::get<std::string>(field);
+                size_t length = storedLength(s);
+                *data++ = static_cast<uint8_t>(length);
+                std::memcpy(data, s.data(), length);
+                data += length;
+                break;
+            }
+        }
+    }
+}
+
+Tuple TupleDesc::deserialize_compact(const uint8_t *data) const {
+    std::vector<field_t> fields;
+    fields.reserve(types.size());
+    for (const type_t &type: types) {
+        switch (type) {
+            case type_t::INT: {
+                int value;
+                std::memcpy(&value, data, INT_SIZE);
+                fields.emplace_back(value);
+                data += INT_SIZE;
+                break;
+            }
+            case type_t::DOUBLE: {
+                double value;
+                std::memcpy(&value, data, DOUBLE_SIZE);
+                fields.emplace_back(value);
+                data += DOUBLE_SIZE;
+                break;
+            }
+            case type_t::CHAR: {
+                size_t length = *data++;
+                fields.emplace_back(std::string(reinterpret_cast<const char *>(data), length));
+                data += length;
+                break;
+            }
+        }
+    }
+    return {fields};
+}
+
 db::TupleDesc TupleDesc::merge(const TupleDesc &td1, const TupleDesc &td2) {
     // TODO pa1
     std::vector<type_t> types(td1.types);
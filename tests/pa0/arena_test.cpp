@@ -0,0 +1,29 @@
+#include <gtest/gtest.h>
+
+#include <db/Database.hpp>
+#include <db/DbFile.hpp>
+
+TEST(ArenaTest, alignedFrames) {
+    // mmap aligns the arena to the system page size only, which is smaller than a page of 8 KiB or more
+    db::Database &db = db::getDatabase();
+    std::string name{"arena"};
+    db::TupleDesc td;
+    for (db::huge_pages_t huge_pages: {db::huge_pages_t::NONE, db::huge_pages_t::TRANSPARENT}) {
+        for (size_t num_pages: {1, 3, 50}) {
+            db::BufferPoolOptions options;
+            options.num_pages = num_pages;
+            options.huge_pages = huge_pages;
+            db.configureBufferPool(options);
+            db::BufferPool &bufferPool = db.getBufferPool();
+            std::remove(name.c_str());
+            db.add(std::make_unique<db::DbFile>(name, td));
+            // every frame is free, so the pages fill all of them
+            for (size_t i = 0; i < num_pages; i++) {
+                db::Page &page = bufferPool.getPage({name, i});
+                EXPECT_EQ(reinterpret_cast<uintptr_t>(page.data()) % db::DEFAULT_PAGE_SIZE, 0);
+                page.fill(static_cast<uint8_t>(i));
+            }
+            db.remove(name);
+        }
+    }
+}
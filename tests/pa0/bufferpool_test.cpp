@@ -2,6 +2,13 @@
 
 #include <db/Database.hpp>
 #include <db/DbFile.hpp>
+#include <db/Replacer.hpp>
+#include <csignal>
+#include <fstream>
+#include <random>
+#include <thread>
+#include <sys/resource.h>
+#include <unistd.h>
 
 TEST(BufferPoolTest, getPage) {
     db::Database &db = db::getDatabase();
@@ -249,3 +256,619 @@ TEST(BufferPoolTest, LRU) {
         EXPECT_EQ(writes[i], size + i);
     }
 }
+
+TEST(BufferPoolTest, configureSize) {
+    constexpr size_t num_pages = 4 * db::DEFAULT_NUM_PAGES;
+    db::Database &db = db::getDatabase();
+    db.configureBufferPool({num_pages, db::huge_pages_t::TRANSPARENT});
+    db::BufferPool &bufferPool = db.getBufferPool();
+    EXPECT_EQ(bufferPool.size(), num_pages);
+
+    std::string name{"file"};
+    db::TupleDesc td;
+    db.add(std::make_unique<db::DbFile>(name, td));
+    std::vector<db::Page *> pages(num_pages);
+    for (size_t i = 0; i < num_pages; i++) {
+        pages[i] = &bufferPool.getPage({name, i});
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(pages[i]) % db::DEFAULT_PAGE_SIZE, 0);
+    }
+    for (size_t i = 0; i < num_pages; i++) {
+        EXPECT_EQ(pages[i], &bufferPool.getPage({name, i}));
+    }
+
+    const db::DbFile &file = db.get(name);
+    EXPECT_EQ(file.getReads().size(), num_pages);
+    EXPECT_ANY_THROW(db.configureBufferPool({0}));
+}
+
+TEST(BufferPoolTest, CLOCK) {
+    db::Database &db = db::getDatabase();
+    db.configureBufferPool({db::DEFAULT_NUM_PAGES, db::huge_pages_t::NONE, db::replacement_t::CLOCK});
+    db::BufferPool &bufferPool = db.getBufferPool();
+
+    std::string name{"file"};
+    db::TupleDesc td;
+    db.add(std::make_unique<db::DbFile>(name, td));
+    for (size_t i = 0; i < db::DEFAULT_NUM_PAGES; i++) {
+        bufferPool.getPage({name, i});
+    }
+
+    // every page is referenced, so the hand clears all bits and comes back to the first page
+    bufferPool.getPage({name, db::DEFAULT_NUM_PAGES});
+    EXPECT_FALSE(bufferPool.contains({name, 0}));
+
+    constexpr size_t size = 10;
+    // pages [1, size) get a second chance
+    for (size_t i = 1; i < size; i++) {
+        bufferPool.getPage({name, i});
+    }
+    bufferPool.getPage({name, db::DEFAULT_NUM_PAGES + 1});
+    for (size_t i = 1; i < size; i++) {
+        EXPECT_TRUE(bufferPool.contains({name, i}));
+    }
+    EXPECT_FALSE(bufferPool.contains({name, size}));
+    EXPECT_TRUE(bufferPool.contains({name, size + 1}));
+}
+
+TEST(BufferPoolTest, TwoQScanResistance) {
+    db::Database &db = db::getDatabase();
+    db.configureBufferPool({db::DEFAULT_NUM_PAGES, db::huge_pages_t::NONE, db::replacement_t::TWO_Q});
+    db::BufferPool &bufferPool = db.getBufferPool();
+
+    std::string name{"file"};
+    db::TupleDesc td;
+    db.add(std::make_unique<db::DbFile>(name, td));
+    constexpr size_t hot = 10;
+    for (size_t i = 0; i < hot; i++) {
+        bufferPool.getPage({name, i});
+    }
+    // a scan pushes the hot pages out once, the next reference makes them hot
+    for (size_t i = 0; i < db::DEFAULT_NUM_PAGES; i++) {
+        bufferPool.getPage({name, 100 + i});
+    }
+    for (size_t i = 0; i < hot; i++) {
+        EXPECT_FALSE(bufferPool.contains({name, i}));
+        bufferPool.getPage({name, i});
+    }
+
+    // a long scan does not evict the hot pages anymore
+    for (size_t i = 0; i < 4 * db::DEFAULT_NUM_PAGES; i++) {
+        bufferPool.getPage({name, 200 + i});
+    }
+    bufferPool.resetStats();
+    for (size_t i = 0; i < hot; i++) {
+        EXPECT_TRUE(bufferPool.contains({name, i}));
+        bufferPool.getPage({name, i});
+    }
+    const db::BufferPoolStats &stats = bufferPool.getStats();
+    EXPECT_EQ(stats.hits, hot);
+    EXPECT_EQ(stats.misses, 0);
+    EXPECT_EQ(stats.hitRatio(), 1.0);
+}
+
+TEST(BufferPoolTest, TwoQGhosts) {
+    // 8 frames: A1in holds 2 pages before it is drained first
+    db::TwoQReplacer replacer(8);
+    db::PageId p0{0, 0}, p1{0, 1};
+    auto any = [](size_t) { return true; };
+    replacer.insert(0, p0);
+    replacer.insert(1, p1);
+
+    // choosing a victim that is then not evicted (e.g. it was pinned meanwhile) leaves no history
+    EXPECT_EQ(replacer.victim(any), 0);
+    replacer.erase(0);
+    replacer.insert(0, p0);
+    EXPECT_EQ(replacer.order(), (std::vector<size_t>{1, 0}));
+
+    // an eviction from A1in is remembered: the next reference to the page makes it hot
+    EXPECT_EQ(replacer.victim(any), 1);
+    replacer.evicted(1);
+    replacer.insert(1, p1);
+    EXPECT_EQ(replacer.order(), (std::vector<size_t>{1, 0}));
+    EXPECT_EQ(replacer.victim(any), 1);
+}
+
+TEST(BufferPoolTest, stats) {
+    db::Database &db = db::getDatabase();
+    db::BufferPool &bufferPool = db.getBufferPool();
+
+    std::string name{"file"};
+    db::TupleDesc td;
+    db.add(std::make_unique<db::DbFile>(name, td));
+    for (size_t i = 0; i < db::DEFAULT_NUM_PAGES + 10; i++) {
+        bufferPool.getPage({name, i});
+    }
+    bufferPool.getPage({name, db::DEFAULT_NUM_PAGES});
+    const db::BufferPoolStats &stats = bufferPool.getStats();
+    EXPECT_EQ(stats.hits, 1);
+    EXPECT_EQ(stats.misses, db::DEFAULT_NUM_PAGES + 10);
+    EXPECT_EQ(stats.evictions, 10);
+}
+
+TEST(BufferPoolTest, concurrentShards) {
+    constexpr size_t num_threads = 4;
+    constexpr size_t pages_per_thread = 64;
+    db::Database &db = db::getDatabase();
+    db.configureBufferPool({num_threads * pages_per_thread, db::huge_pages_t::NONE, db::replacement_t::LRU, 8});
+    db::BufferPool &bufferPool = db.getBufferPool();
+    EXPECT_EQ(bufferPool.getNumShards(), 8);
+
+    std::string name{"file"};
+    db::TupleDesc td;
+    db.add(std::make_unique<db::DbFile>(name, td));
+    db::file_id_t file = db.getFileId(name);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < num_threads; t++) {
+        threads.emplace_back([&bufferPool, file, t] {
+            for (size_t round = 0; round < 10; round++) {
+                for (size_t i = t * pages_per_thread; i < (t + 1) * pages_per_thread; i++) {
+                    bufferPool.getPage({file, i});
+                    bufferPool.markDirty({file, i});
+                }
+            }
+        });
+    }
+    for (std::thread &thread: threads) {
+        thread.join();
+    }
+
+    // the shards may fill unevenly, so some pages may have been evicted
+    db::BufferPoolStats stats = bufferPool.getStats();
+    EXPECT_EQ(stats.hits + stats.misses, 10 * num_threads * pages_per_thread);
+    EXPECT_EQ(db.get(name).getReads().size(), stats.misses);
+    bufferPool.flushFile(name);
+    for (size_t i = 0; i < num_threads * pages_per_thread; i++) {
+        if (bufferPool.contains({file, i})) {
+            EXPECT_FALSE(bufferPool.isDirty({file, i}));
+        }
+    }
+}
+
+TEST(BufferPoolTest, pin) {
+    db::Database &db = db::getDatabase();
+    db::BufferPool &bufferPool = db.getBufferPool();
+
+    std::string name{"file"};
+    db::TupleDesc td;
+    db.add(std::make_unique<db::DbFile>(name, td));
+    db::PageGuard guard = bufferPool.pin({name, 0});
+    db::Page *page = &*guard;
+    (*guard)[0] = 42;
+    guard.markDirty();
+
+    // the pinned page survives a full sweep of the pool
+    for (size_t i = 1; i < 3 * db::DEFAULT_NUM_PAGES; i++) {
+        bufferPool.getPage({name, i});
+    }
+    EXPECT_TRUE(bufferPool.contains({name, 0}));
+    EXPECT_EQ(page, &bufferPool.getPage({name, 0}));
+    EXPECT_EQ((*guard)[0], 42);
+    EXPECT_ANY_THROW(bufferPool.discardPage({name, 0}));
+
+    // once released, the page can be evicted (and is flushed)
+    guard.release();
+    EXPECT_FALSE(guard);
+    for (size_t i = 1; i <= db::DEFAULT_NUM_PAGES; i++) {
+        bufferPool.getPage({name, i});
+    }
+    EXPECT_FALSE(bufferPool.contains({name, 0}));
+    EXPECT_EQ(bufferPool.getPage({name, 0})[0], 42);
+}
+
+TEST(BufferPoolTest, allPinned) {
+    db::Database &db = db::getDatabase();
+    db::BufferPool &bufferPool = db.getBufferPool();
+
+    std::string name{"file"};
+    db::TupleDesc td;
+    db.add(std::make_unique<db::DbFile>(name, td));
+    std::vector<db::PageGuard> guards;
+    for (size_t i = 0; i < db::DEFAULT_NUM_PAGES; i++) {
+        guards.push_back(bufferPool.pin({name, i}, db::latch_t::SHARED));
+    }
+    EXPECT_ANY_THROW(bufferPool.getPage({name, db::DEFAULT_NUM_PAGES}));
+    guards.pop_back();
+    EXPECT_NO_THROW(bufferPool.getPage({name, db::DEFAULT_NUM_PAGES}));
+    EXPECT_FALSE(bufferPool.contains({name, db::DEFAULT_NUM_PAGES - 1}));
+}
+
+TEST(BufferPoolTest, backgroundWriter) {
+    db::Database &db = db::getDatabase();
+    db::BufferPoolOptions options;
+    options.clean_target = 0.5;
+    options.writer_pages_per_second = 100'000;
+    options.writer_interval = std::chrono::milliseconds(1);
+    db.configureBufferPool(options);
+    db::BufferPool &bufferPool = db.getBufferPool();
+
+    std::string name{"file"};
+    db::TupleDesc td;
+    db.add(std::make_unique<db::DbFile>(name, td));
+    db::PageGuard pinned = bufferPool.pin({name, 0});
+    pinned.markDirty();
+    for (size_t i = 1; i < db::DEFAULT_NUM_PAGES; i++) {
+        bufferPool.getPage({name, i});
+        bufferPool.markDirty({name, i});
+    }
+
+    // the writer cleans the oldest unpinned pages until half of the pool is clean
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (bufferPool.getStats().background_writes < db::DEFAULT_NUM_PAGES / 2 &&
+           std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(bufferPool.getStats().background_writes, db::DEFAULT_NUM_PAGES / 2);
+    EXPECT_TRUE(bufferPool.isDirty({name, 0}));
+    EXPECT_FALSE(bufferPool.isDirty({name, 1}));
+    EXPECT_TRUE(bufferPool.isDirty({name, db::DEFAULT_NUM_PAGES - 1}));
+
+    // evicting a cleaned page does not write in the foreground
+    size_t writes = db.get(name).getWrites().size();
+    bufferPool.getPage({name, db::DEFAULT_NUM_PAGES});
+    EXPECT_EQ(db.get(name).getWrites().size(), writes);
+}
+
+TEST(BufferPoolTest, backgroundWriterRate) {
+    db::Database &db = db::getDatabase();
+    db::BufferPoolOptions options;
+    options.num_pages = 200;
+    options.clean_target = 0.5;
+    options.writer_pages_per_second = 0;
+    options.writer_interval = std::chrono::milliseconds(1);
+    db.configureBufferPool(options);
+
+    std::string name{"file"};
+    db::TupleDesc td;
+    db.add(std::make_unique<db::DbFile>(name, td));
+    auto dirtyAll = [&db, &name] {
+        for (size_t i = 0; i < 200; i++) {
+            db.getBufferPool().getPage({name, i});
+            db.getBufferPool().markDirty({name, i});
+        }
+    };
+
+    // a rate of 0 pages per second leaves the writer idle
+    dirtyAll();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_EQ(db.getBufferPool().getStats().background_writes, 0);
+
+    // 100 pages per second is a tenth of a page per wakeup: the writer does not round it up to a page per wakeup
+    options.writer_pages_per_second = 100;
+    db.configureBufferPool(options);
+    dirtyAll();
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    size_t writes = db.getBufferPool().getStats().background_writes;
+    EXPECT_GT(writes, 0);
+    EXPECT_LE(writes, 40);
+}
+
+TEST(BufferPoolTest, readAhead) {
+    constexpr size_t num_pages = 64;
+    std::string name{"file"};
+    {
+        std::remove(name.c_str());
+        std::ofstream out(name, std::ios::binary);
+        std::vector<char> data(num_pages * db::DEFAULT_PAGE_SIZE);
+        out.write(data.data(), static_cast<std::streamsize>(data.size()));
+    }
+    db::Database &db = db::getDatabase();
+    db::BufferPoolOptions options;
+    options.readahead_max_pages = 16;
+    db.configureBufferPool(options);
+    db::BufferPool &bufferPool = db.getBufferPool();
+    db::TupleDesc td;
+    db.add(std::make_unique<db::DbFile>(name, td));
+    ASSERT_EQ(db.get(name).getNumPages(), num_pages);
+
+    auto wait_for = [&bufferPool](const db::PageId &pid) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (!bufferPool.contains(pid) && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return bufferPool.contains(pid);
+    };
+
+    // random accesses do not start a read-ahead
+    bufferPool.getPage({name, 40});
+    bufferPool.getPage({name, 20});
+    bufferPool.getPage({name, 20});
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(bufferPool.getStats().prefetches, 0);
+
+    // the second page of a run starts a read-ahead of the next pages
+    bufferPool.getPage({name, 0});
+    bufferPool.getPage({name, 1});
+    EXPECT_TRUE(wait_for({name, 1 + db::READAHEAD_MIN_PAGES}));
+
+    // the rest of a scan is served from the read-ahead
+    for (size_t i = 2; i < num_pages; i++) {
+        EXPECT_TRUE(wait_for({name, i}));
+        bufferPool.getPage({name, i});
+    }
+    db::BufferPoolStats stats = bufferPool.getStats();
+    // pages 20 and 40 were already resident
+    EXPECT_EQ(stats.misses, 4);
+    EXPECT_EQ(stats.prefetches, num_pages - 4);
+    EXPECT_EQ(db.get(name).getReads().size(), num_pages);
+}
+
+TEST(BufferPoolTest, shortReadAhead) {
+    constexpr size_t num_pages = 8;
+    std::string name{"file"};
+    {
+        std::remove(name.c_str());
+        std::ofstream out(name, std::ios::binary);
+        std::vector<char> data(num_pages * db::DEFAULT_PAGE_SIZE, 1);
+        out.write(data.data(), static_cast<std::streamsize>(data.size()));
+    }
+    db::Database &db = db::getDatabase();
+    db::BufferPoolOptions options;
+    options.readahead_max_pages = 16;
+    db.configureBufferPool(options);
+    db::BufferPool &bufferPool = db.getBufferPool();
+    db::TupleDesc td;
+    db.add(std::make_unique<db::DbFile>(name, td));
+    ASSERT_EQ(db.get(name).getNumPages(), num_pages);
+    // the file shrinks behind the DbFile: the read-ahead of pages 2 to 5 only reads page 2
+    ASSERT_EQ(truncate(name.c_str(), 3 * db::DEFAULT_PAGE_SIZE), 0);
+
+    bufferPool.getPage({name, 0});
+    bufferPool.getPage({name, 1});
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (bufferPool.getStats().prefetches == 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(bufferPool.getStats().prefetches, 1);
+    EXPECT_TRUE(bufferPool.contains({name, 2}));
+    for (size_t i = 3; i < 2 + db::READAHEAD_MIN_PAGES; i++) {
+        EXPECT_FALSE(bufferPool.contains({name, i}));
+    }
+}
+
+TEST(BufferPoolTest, failedEviction) {
+    db::Database &db = db::getDatabase();
+    db::BufferPoolOptions options;
+    options.num_pages = 2;
+    db.configureBufferPool(options);
+    db::BufferPool &bufferPool = db.getBufferPool();
+    std::string name{"file"};
+    std::remove(name.c_str());
+    db::TupleDesc td;
+    db.add(std::make_unique<db::DbFile>(name, td));
+    bufferPool.getPage({name, 4});
+    bufferPool.markDirty({name, 4});
+    bufferPool.getPage({name, 5});
+    bufferPool.markDirty({name, 5});
+
+    // with a file size limit the victim cannot be written: the miss fails, but the frame is not lost
+    struct rlimit limit{};
+    ASSERT_EQ(getrlimit(RLIMIT_FSIZE, &limit), 0);
+    struct sigaction ignore{}, old{};
+    ignore.sa_handler = SIG_IGN;
+    sigaction(SIGXFSZ, &ignore, &old);
+    struct rlimit small = limit;
+    small.rlim_cur = 2 * db::DEFAULT_PAGE_SIZE;
+    ASSERT_EQ(setrlimit(RLIMIT_FSIZE, &small), 0);
+    EXPECT_THROW(bufferPool.getPage({name, 0}), std::runtime_error);
+    ASSERT_EQ(setrlimit(RLIMIT_FSIZE, &limit), 0);
+    sigaction(SIGXFSZ, &old, nullptr);
+    EXPECT_TRUE(bufferPool.isDirty({name, 4}));
+
+    // both frames can be used again
+    bufferPool.getPage({name, 0});
+    bufferPool.getPage({name, 1});
+    EXPECT_TRUE(bufferPool.contains({name, 0}));
+    EXPECT_TRUE(bufferPool.contains({name, 1}));
+    db.remove(name);
+}
+
+TEST(BufferPoolTest, sortedFlush) {
+    db::Database &db = db::getDatabase();
+    db::BufferPool &bufferPool = db.getBufferPool();
+
+    std::string name{"file"};
+    std::remove(name.c_str());
+    db::TupleDesc td;
+    db.add(std::make_unique<db::DbFile>(name, td));
+    // dirty runs of consecutive pages with gaps, in a scrambled order
+    std::vector<size_t> ids{7, 3, 12, 0, 4, 11, 2, 8, 1, 13};
+    for (size_t id: ids) {
+        db::Page &page = bufferPool.getPage({name, id});
+        page.fill(static_cast<uint8_t>(id + 1));
+        bufferPool.markDirty({name, id});
+    }
+    bufferPool.flushFile(name);
+
+    std::vector<size_t> sorted = ids;
+    std::sort(sorted.begin(), sorted.end());
+    EXPECT_EQ(db.get(name).getWrites().retained(), sorted);
+
+    std::ifstream in(name, std::ios::binary);
+    for (size_t id = 0; id <= sorted.back(); id++) {
+        db::Page page;
+        in.read(reinterpret_cast<char *>(page.data()), db::DEFAULT_PAGE_SIZE);
+        bool written = std::find(ids.begin(), ids.end(), id) != ids.end();
+        EXPECT_EQ(page[0], written ? id + 1 : 0);
+        EXPECT_EQ(page[db::DEFAULT_PAGE_SIZE - 1], written ? id + 1 : 0);
+    }
+}
+
+TEST(BufferPoolTest, shardedFlush) {
+    db::Database &db = db::getDatabase();
+    db::BufferPoolOptions options;
+    options.num_shards = 4;
+    db.configureBufferPool(options);
+    db::BufferPool &bufferPool = db.getBufferPool();
+
+    std::string name{"file"};
+    std::remove(name.c_str());
+    db::TupleDesc td;
+    db.add(std::make_unique<db::DbFile>(name, td));
+    db::DbFile &file = db.get(name);
+    // two runs of consecutive pages, each spread over every shard
+    std::vector<size_t> ids;
+    for (size_t id = 0; id < 10; id++) {
+        ids.push_back(id);
+        ids.push_back(id + 20);
+    }
+    for (size_t id: ids) {
+        db::Page &page = bufferPool.getPage({name, id});
+        page.fill(static_cast<uint8_t>(id + 1));
+        bufferPool.markDirty({name, id});
+    }
+    file.resetIoStats();
+    bufferPool.flushAll();
+
+    std::sort(ids.begin(), ids.end());
+    EXPECT_EQ(file.getWrites().retained(), ids);
+    EXPECT_EQ(file.getIoStats().writes, ids.size());
+    EXPECT_EQ(file.getIoStats().write_requests, 2);
+    for (size_t id: ids) {
+        EXPECT_FALSE(bufferPool.isDirty({name, id}));
+    }
+
+    std::ifstream in(name, std::ios::binary);
+    for (size_t id = 0; id <= ids.back(); id++) {
+        db::Page page;
+        in.read(reinterpret_cast<char *>(page.data()), db::DEFAULT_PAGE_SIZE);
+        bool written = std::find(ids.begin(), ids.end(), id) != ids.end();
+        EXPECT_EQ(page[0], written ? id + 1 : 0);
+    }
+}
+
+TEST(BufferPoolTest, ioStats) {
+    db::Database &db = db::getDatabase();
+    db::BufferPool &bufferPool = db.getBufferPool();
+
+    std::string name{"file"};
+    db::TupleDesc td;
+    db.add(std::make_unique<db::DbFile>(name, td));
+    db::DbFile &file = db.get(name);
+    file.setTraceCapacity(8);
+    for (size_t i = 0; i < db::DEFAULT_NUM_PAGES + 10; i++) {
+        bufferPool.getPage({name, i});
+        bufferPool.markDirty({name, i});
+    }
+    bufferPool.getPage({name, db::DEFAULT_NUM_PAGES + 9});
+
+    db::IoStats io = file.getIoStats();
+    EXPECT_EQ(io.reads, db::DEFAULT_NUM_PAGES + 10);
+    EXPECT_EQ(io.writes, 10);
+    EXPECT_EQ(io.bytes_read, io.reads * db::DEFAULT_PAGE_SIZE);
+    EXPECT_EQ(io.bytes_written, io.writes * db::DEFAULT_PAGE_SIZE);
+    EXPECT_EQ(io.read_latency.count, io.reads);
+    EXPECT_EQ(io.write_latency.count, io.writes);
+
+    // the traces only keep the most recent pages
+    EXPECT_EQ(file.getReads().size(), io.reads);
+    EXPECT_EQ(file.getReads().retained().size(), 8);
+    EXPECT_EQ(file.getReads()[db::DEFAULT_NUM_PAGES + 9], db::DEFAULT_NUM_PAGES + 9);
+    EXPECT_EQ(file.getWrites()[9], 9);
+
+    db::BufferPoolStats stats = bufferPool.getStats();
+    EXPECT_EQ(stats.hits, 1);
+    EXPECT_EQ(stats.misses, db::DEFAULT_NUM_PAGES + 10);
+    EXPECT_EQ(stats.evictions, 10);
+    EXPECT_EQ(stats.writebacks, 10);
+    EXPECT_EQ(stats.miss_latency.count, stats.misses);
+    EXPECT_GE(stats.miss_latency.percentile(99), stats.miss_latency.percentile(50));
+
+    bufferPool.flushFile(name);
+    EXPECT_EQ(bufferPool.getStats().writebacks, db::DEFAULT_NUM_PAGES + 10);
+    file.resetIoStats();
+    bufferPool.resetStats();
+    EXPECT_EQ(file.getIoStats().writes, 0);
+    EXPECT_EQ(file.getWrites().size(), 0);
+    EXPECT_EQ(bufferPool.getStats().miss_latency.count, 0);
+}
+
+TEST(BufferPoolTest, scanRing) {
+    db::Database &db = db::getDatabase();
+    db::BufferPool &bufferPool = db.getBufferPool();
+
+    std::string hot{"hot"};
+    std::string scanned{"scanned"};
+    db::TupleDesc td;
+    db.add(std::make_unique<db::DbFile>(hot, td));
+    db.add(std::make_unique<db::DbFile>(scanned, td));
+    constexpr size_t num_hot = db::DEFAULT_NUM_PAGES - 10;
+    for (size_t i = 0; i < num_hot; i++) {
+        bufferPool.getPage({hot, i});
+    }
+
+    EXPECT_EQ(bufferPool.makeScanRing(db::DEFAULT_NUM_PAGES), nullptr);
+    std::shared_ptr<db::BufferRing> ring = bufferPool.makeScanRing(2 * db::DEFAULT_NUM_PAGES);
+    ASSERT_NE(ring, nullptr);
+    EXPECT_EQ(ring->size(), db::SCAN_RING_PAGES);
+    ring = std::make_shared<db::BufferRing>(4);
+    for (size_t i = 0; i < 2 * db::DEFAULT_NUM_PAGES; i++) {
+        db::PageGuard guard = bufferPool.pin({scanned, i}, db::latch_t::SHARED, ring.get());
+        if (i == 10) {
+            guard.markDirty();
+        }
+    }
+
+    // the scan recycled its own frames: the rest of the pool survived
+    for (size_t i = 0; i < num_hot; i++) {
+        EXPECT_TRUE(bufferPool.contains({hot, i}));
+    }
+    for (size_t i = 0; i < 2 * db::DEFAULT_NUM_PAGES; i++) {
+        EXPECT_EQ(bufferPool.contains({scanned, i}), i >= 2 * db::DEFAULT_NUM_PAGES - 4);
+    }
+    db::BufferPoolStats stats = bufferPool.getStats();
+    EXPECT_EQ(stats.evictions, 0);
+    EXPECT_EQ(stats.recycled, 2 * db::DEFAULT_NUM_PAGES - 4);
+    // a dirty page is written before its frame is recycled
+    EXPECT_EQ(db.get(scanned).getWrites().retained(), std::vector<size_t>{10});
+
+    // a page pinned elsewhere is not recycled
+    db::PageGuard pinned = bufferPool.pin({scanned, 2 * db::DEFAULT_NUM_PAGES - 4});
+    for (size_t i = 0; i < 4; i++) {
+        bufferPool.pin({hot, num_hot + i}, db::latch_t::NONE, ring.get());
+    }
+    EXPECT_TRUE(bufferPool.contains({scanned, 2 * db::DEFAULT_NUM_PAGES - 4}));
+}
+
+TEST(BufferPoolTest, optimisticPins) {
+    constexpr size_t num_pages = 4 * db::DEFAULT_NUM_PAGES;
+    std::string name{"file"};
+    {
+        std::remove(name.c_str());
+        std::ofstream out(name, std::ios::binary);
+        for (size_t i = 0; i < num_pages; i++) {
+            std::vector<char> page(db::DEFAULT_PAGE_SIZE, static_cast<char>(i));
+            out.write(page.data(), static_cast<std::streamsize>(page.size()));
+        }
+    }
+    db::Database &db = db::getDatabase();
+    db::BufferPoolOptions options;
+    options.num_shards = 4;
+    db.configureBufferPool(options);
+    db::BufferPool &bufferPool = db.getBufferPool();
+    db::TupleDesc td;
+    db.add(std::make_unique<db::DbFile>(name, td));
+    db::file_id_t file = db.getFileId(name);
+
+    // hits race with evictions of the same frames: a pinned frame must always hold the requested page
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < 4; t++) {
+        threads.emplace_back([&bufferPool, file, t] {
+            std::mt19937 gen(t);
+            for (size_t i = 0; i < 5'000; i++) {
+                // most accesses hit a small hot set, the others force evictions
+                size_t page = gen() % 4 == 0 ? gen() % num_pages : gen() % 16;
+                db::PageGuard guard = bufferPool.pin({file, page}, db::latch_t::SHARED);
+                ASSERT_EQ((*guard)[0], static_cast<uint8_t>(page));
+                ASSERT_EQ((*guard)[db::DEFAULT_PAGE_SIZE - 1], static_cast<uint8_t>(page));
+            }
+        });
+    }
+    for (std::thread &thread: threads) {
+        thread.join();
+    }
+    db::BufferPoolStats stats = bufferPool.getStats();
+    EXPECT_EQ(stats.hits + stats.misses, 4 * 5'000);
+    EXPECT_EQ(db.get(name).getReads().size(), stats.misses);
+}
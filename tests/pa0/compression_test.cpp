@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+
+#include <db/Compression.hpp>
+#include <db/PageMap.hpp>
+#include <db/types.hpp>
+#include <random>
+
+static std::vector<uint8_t> roundTrip(const std::vector<uint8_t> &block) {
+    std::vector<uint8_t> compressed(block.size() + block.size() / 255 + 16);
+    size_t size = db::lzCompress(block, compressed);
+    EXPECT_GT(size, 0);
+    compressed.resize(size);
+    std::vector<uint8_t> decompressed(block.size());
+    db::lzDecompress(compressed, decompressed);
+    EXPECT_EQ(decompressed, block);
+    return compressed;
+}
+
+TEST(CompressionTest, lz) {
+    // a page of short strings padded with zeros shrinks a lot
+    std::vector<uint8_t> page(db::DEFAULT_PAGE_SIZE);
+    for (size_t i = 0; i + 64 <= page.size(); i += 77) {
+        std::snprintf(reinterpret_cast<char *>(&page[i]), 64, "name %zu", i);
+    }
+    std::vector<uint8_t> compressed = roundTrip(page);
+    EXPECT_LT(compressed.size(), page.size() / 4);
+
+    // random bytes do not fit in a smaller buffer, but still round-trip in a large enough one
+    std::vector<uint8_t> noise(db::DEFAULT_PAGE_SIZE);
+    std::mt19937 gen(1);
+    for (uint8_t &byte: noise) {
+        byte = static_cast<uint8_t>(gen());
+    }
+    std::vector<uint8_t> small(noise.size() - 1);
+    EXPECT_EQ(db::lzCompress(noise, small), 0);
+    roundTrip(noise);
+    roundTrip({});
+    roundTrip({1, 2, 3});
+
+    // long runs and long literal sequences use the extra length bytes
+    std::vector<uint8_t> mixed(noise.begin(), noise.begin() + 1000);
+    mixed.resize(mixed.size() + 2000, 7);
+    compressed = roundTrip(mixed);
+    EXPECT_LT(compressed.size(), 1100);
+
+    // a corrupt block is detected
+    std::vector<uint8_t> decompressed(mixed.size());
+    compressed.back() ^= 0xff;
+    compressed.push_back(0x0f);
+    EXPECT_THROW(db::lzDecompress(compressed, decompressed), std::runtime_error);
+    decompressed.resize(mixed.size() + 1);
+    EXPECT_THROW(db::lzDecompress(std::span(compressed).first(compressed.size() - 1), decompressed),
+                 std::runtime_error);
+}
+
+TEST(CompressionTest, pageMap) {
+    std::string path{"pages.map"};
+    std::remove(path.c_str());
+    {
+        db::PageMap map(path);
+        EXPECT_EQ(map.size(), 0);
+        EXPECT_EQ(map.place(0, 300).offset, 0);
+        EXPECT_EQ(map.place(1, 100).offset, 512);
+        // a page that still fits in its slot stays in place, a larger one moves to the end of the file
+        EXPECT_EQ(map.place(0, 500).offset, 0);
+        db::PageExtent moved = map.place(0, 600);
+        EXPECT_EQ(moved.offset, 768);
+        EXPECT_EQ(moved.capacity, 768);
+        // the slot it left is reused
+        EXPECT_EQ(map.place(3, 400).offset, 0);
+        EXPECT_EQ(map.size(), 4);
+        EXPECT_EQ(map.get(2).length, 0);
+        EXPECT_EQ(map.get(10).length, 0);
+    }
+
+    // the map and its free slots are found again when it is reopened
+    db::PageMap map(path);
+    EXPECT_EQ(map.size(), 4);
+    EXPECT_EQ(map.get(0).offset, 768);
+    EXPECT_EQ(map.get(0).length, 600);
+    EXPECT_EQ(map.get(1).offset, 512);
+    EXPECT_EQ(map.place(2, 256).offset, 1536);
+    map.place(1, 700);
+    EXPECT_EQ(map.place(4, 200).offset, 512);
+
+    // dropped pages are forgotten, and their slots are reused
+    map.truncate(2);
+    EXPECT_EQ(map.size(), 2);
+    EXPECT_EQ(map.get(3).length, 0);
+    EXPECT_EQ(map.place(2, 200).offset, 1536);
+    EXPECT_EQ(db::PageMap(path).size(), 3);
+}
@@ -2,6 +2,7 @@
 
 #include <db/Database.hpp>
 #include <db/DbFile.hpp>
+#include <fstream>
 
 TEST(DatabaseTest, AddDbFile) {
     db::Database &db = db::getDatabase();
@@ -116,3 +117,165 @@ TEST(DatabaseTest, MultipleOperations) {
     db.add(std::move(file));
     EXPECT_EQ(expected, &db.get(name2));
 }
+
+TEST(DatabaseTest, FileIds) {
+    db::Database &db = db::getDatabase();
+    db::TupleDesc td;
+    db.add(std::make_unique<db::DbFile>("test1", td));
+    db.add(std::make_unique<db::DbFile>("test2", td));
+    db::file_id_t id1 = db.getFileId("test1");
+    db::file_id_t id2 = db.getFileId("test2");
+    EXPECT_NE(id1, id2);
+    EXPECT_EQ(db.get("test1").getId(), id1);
+    EXPECT_EQ(&db.get(id2), &db.get("test2"));
+    EXPECT_EQ(db::PageId("test2", 3), db::PageId(id2, 3));
+    EXPECT_ANY_THROW(db::PageId("test3", 0));
+
+    // page numbers are 32-bit: larger ones are rejected instead of aliasing another page
+    EXPECT_EQ(db::PageId(id2, UINT32_MAX).page, UINT32_MAX);
+    EXPECT_THROW(db::PageId(id2, size_t{UINT32_MAX} + 1), std::out_of_range);
+    EXPECT_THROW(db::PageId("test2", SIZE_MAX), std::out_of_range);
+
+    // a name keeps its id after it is removed and added again
+    auto file = db.remove("test1");
+    EXPECT_ANY_THROW(db.get(id1));
+    db.add(std::move(file));
+    EXPECT_EQ(db.getFileId("test1"), id1);
+    EXPECT_EQ(db.get(id1).getId(), id1);
+}
+
+TEST(DatabaseTest, DirectIo) {
+    std::string name{"direct"};
+    std::remove(name.c_str());
+    db::TupleDesc td;
+    db::DbFileOptions options;
+    options.direct_io = true;
+    db::DbFile file(name, td, options);
+    // the test directory may be on a filesystem without O_DIRECT (e.g. tmpfs): the file falls back to buffered I/O
+    EXPECT_FALSE(db::DbFile(name, td).isDirect());
+
+    // pages that are not aligned go through a bounce buffer
+    std::vector<uint8_t> storage(2 * db::DEFAULT_PAGE_SIZE + 1);
+    auto *misaligned = reinterpret_cast<db::Page *>(storage.data() + 1);
+    misaligned->fill(7);
+    file.writePage(*misaligned, 1);
+    auto *aligned = reinterpret_cast<db::Page *>(std::aligned_alloc(db::DEFAULT_PAGE_SIZE, db::DEFAULT_PAGE_SIZE));
+    file.readPage(*aligned, 1);
+    file.readPage(*misaligned, 0);
+    EXPECT_EQ((*aligned)[0], 7);
+    EXPECT_EQ((*aligned)[db::DEFAULT_PAGE_SIZE - 1], 7);
+    EXPECT_EQ((*misaligned)[0], 0);
+    std::free(aligned);
+
+    // the pages are read back through the buffer pool, whose frames are aligned
+    db::Database &db = db::getDatabase();
+    db.add(std::make_unique<db::DbFile>(name, td, options));
+    EXPECT_EQ(db.getBufferPool().getPage({name, 1})[0], 7);
+}
+
+TEST(DatabaseTest, Warmup) {
+    db::Database &db = db::getDatabase();
+    db::TupleDesc td;
+    std::string first{"first file"};
+    std::string second{"second"};
+    std::string list{"warmup.list"};
+    std::remove(list.c_str());
+    std::remove(first.c_str());
+    std::remove(second.c_str());
+    db.add(std::make_unique<db::DbFile>(first, td));
+    db.add(std::make_unique<db::DbFile>(second, td));
+    db::BufferPool &bufferPool = db.getBufferPool();
+    for (size_t i = 0; i < 8; i++) {
+        bufferPool.getPage({second, 7 - i});
+        bufferPool.markDirty({second, 7 - i});
+        bufferPool.getPage({first, i});
+        bufferPool.markDirty({first, i});
+    }
+    bufferPool.getPage({first, 0});
+    db.saveWarmupList(list);
+    {
+        std::ifstream in(list);
+        std::string line;
+        std::getline(in, line);
+        EXPECT_EQ(line, "0 first file");
+        std::getline(in, line);
+        EXPECT_EQ(line, "7 first file");
+        std::getline(in, line);
+        EXPECT_EQ(line, "0 second");
+    }
+
+    // a restart with an empty pool preloads the list in file and page order without blocking
+    db.configureBufferPool({});
+    db::BufferPool &restarted = db.getBufferPool();
+    size_t reads = db.get(first).getReads().size();
+    db.startWarmup(list);
+    EXPECT_EQ(db.waitForWarmup(), 16);
+    EXPECT_EQ(restarted.getStats().misses, 0);
+    EXPECT_EQ(restarted.getStats().prefetches, 16);
+    for (size_t i = 0; i < 8; i++) {
+        EXPECT_TRUE(restarted.contains({first, i}));
+        EXPECT_TRUE(restarted.contains({second, i}));
+        EXPECT_EQ(db.get(first).getReads()[reads + i], i);
+    }
+
+    // a missing list is ignored
+    std::remove(list.c_str());
+    db.startWarmup(list);
+    EXPECT_EQ(db.waitForWarmup(), 0);
+}
+
+TEST(DatabaseTest, ReadPages) {
+    std::string name{"pages"};
+    std::remove(name.c_str());
+    db::TupleDesc td;
+    db::DbFile file(name, td);
+    for (size_t id = 0; id < 8; id++) {
+        db::Page page;
+        page.fill(static_cast<uint8_t>(id + 1));
+        file.writePage(page, id);
+    }
+    file.resetIoStats();
+
+    // a run of consecutive pages is read with one syscall, the pages past the end of the file read as zeros
+    std::vector<db::Page> frames(6);
+    std::vector<db::Page *> pointers;
+    for (db::Page &frame: frames) {
+        frame.fill(0xff);
+        pointers.push_back(&frame);
+    }
+    file.readPages(4, pointers);
+    for (size_t i = 0; i < frames.size(); i++) {
+        uint8_t expected = 4 + i < 8 ? 4 + i + 1 : 0;
+        EXPECT_EQ(frames[i][0], expected);
+        EXPECT_EQ(frames[i][db::DEFAULT_PAGE_SIZE - 1], expected);
+    }
+    db::IoStats io = file.getIoStats();
+    EXPECT_EQ(io.reads, frames.size());
+    EXPECT_EQ(io.bytes_read, frames.size() * db::DEFAULT_PAGE_SIZE);
+    EXPECT_EQ(io.read_latency.count, 1);
+    EXPECT_EQ(file.getReads().retained(), (std::vector<size_t>{4, 5, 6, 7, 8, 9}));
+}
+
+TEST(DatabaseTest, RemoveDiscardsPages) {
+    db::Database &db = db::getDatabase();
+    db::BufferPool &bufferPool = db.getBufferPool();
+    std::string name{"reused"};
+    std::remove(name.c_str());
+    db::TupleDesc td;
+    db.add(std::make_unique<db::DbFile>(name, td));
+    bufferPool.getPage({name, 0}).fill(1);
+    bufferPool.markDirty({name, 0});
+
+    // a pinned page keeps the file in the catalog
+    db::PageGuard guard = bufferPool.pin({name, 0});
+    EXPECT_THROW(db.remove(name), std::logic_error);
+    guard.release();
+    db.remove(name);
+    EXPECT_FALSE(bufferPool.contains({name, 0}));
+
+    // a new file with the same name reuses the file id, but reads its own pages
+    std::remove(name.c_str());
+    db.add(std::make_unique<db::DbFile>(name, td));
+    EXPECT_EQ(bufferPool.getPage({name, 0})[0], 0);
+    db.remove(name);
+}
@@ -0,0 +1,172 @@
+#include <gtest/gtest.h>
+
+#include <db/Database.hpp>
+#include <db/DbFile.hpp>
+#include <db/IoBackend.hpp>
+#include <csignal>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+static void roundTrip(db::IoBackend &io) {
+    constexpr size_t num_pages = 100;
+    std::string name{"file"};
+    std::remove(name.c_str());
+    int fd = open(name.c_str(), O_RDWR | O_CREAT, 0644);
+    ASSERT_NE(fd, -1);
+
+    std::vector<db::Page> pages(num_pages);
+    std::vector<db::IoRequest> requests(num_pages);
+    for (size_t i = 0; i < num_pages; i++) {
+        pages[i].fill(static_cast<uint8_t>(i + 1));
+        requests[i] = {.fd = fd, .write = true, .buffer = pages[i].data(), .length = db::DEFAULT_PAGE_SIZE,
+                       .offset = static_cast<off_t>(i * db::DEFAULT_PAGE_SIZE)};
+    }
+    // the batch is larger than the queue depth
+    io.run(requests);
+    EXPECT_EQ(io.inflight(), 0);
+    for (const db::IoRequest &request: requests) {
+        EXPECT_EQ(request.result, db::DEFAULT_PAGE_SIZE);
+    }
+
+    std::vector<db::Page> read(num_pages + 1);
+    std::vector<db::IoRequest *> batch;
+    for (size_t i = 0; i <= num_pages; i++) {
+        requests.push_back({.fd = fd, .buffer = read[i].data(), .length = db::DEFAULT_PAGE_SIZE,
+                            .offset = static_cast<off_t>(i * db::DEFAULT_PAGE_SIZE)});
+    }
+    for (size_t i = num_pages; i < requests.size(); i++) {
+        batch.push_back(&requests[i]);
+    }
+    io.submit(batch);
+    std::vector<db::IoRequest *> completed;
+    while (completed.size() < batch.size()) {
+        auto reaped = io.reap(1);
+        EXPECT_FALSE(reaped.empty());
+        completed.insert(completed.end(), reaped.begin(), reaped.end());
+    }
+    std::sort(completed.begin(), completed.end());
+    EXPECT_EQ(completed, batch);
+    for (size_t i = 0; i < num_pages; i++) {
+        EXPECT_EQ(read[i], pages[i]);
+    }
+    // reading past the end of the file is a short read
+    EXPECT_EQ(requests.back().result, 0);
+
+    db::IoRequest bad{.fd = -1, .buffer = read[0].data(), .length = db::DEFAULT_PAGE_SIZE};
+    io.run({&bad, 1});
+    EXPECT_EQ(bad.result, -EBADF);
+    close(fd);
+}
+
+TEST(IoBackendTest, sync) {
+    db::SyncIoBackend io;
+    roundTrip(io);
+}
+
+TEST(IoBackendTest, uring) {
+    std::unique_ptr<db::UringIoBackend> io;
+    try {
+        io = std::make_unique<db::UringIoBackend>(16);
+    } catch (const std::runtime_error &) {
+        GTEST_SKIP() << "io_uring is not available";
+    }
+    roundTrip(*io);
+}
+
+TEST(IoBackendTest, fallback) {
+    EXPECT_NE(dynamic_cast<db::SyncIoBackend *>(db::makeIoBackend(db::io_backend_t::SYNC, 16).get()), nullptr);
+    EXPECT_NE(db::makeIoBackend(db::io_backend_t::IO_URING, 16), nullptr);
+}
+
+TEST(IoBackendTest, bufferPool) {
+    constexpr size_t num_pages = 64;
+    db::Database &db = db::getDatabase();
+    // with several shards, every shard submits the requests that start with one of its pages to its own ring
+    for (size_t num_shards: {1, 4}) {
+        db::BufferPoolOptions options;
+        // the pages are spread over the shards by hash: leave room for an uneven spread
+        options.num_pages = 2 * num_pages;
+        options.num_shards = num_shards;
+        options.readahead_max_pages = 16;
+        options.io_backend = db::io_backend_t::IO_URING;
+        options.io_queue_depth = 8;
+        db.configureBufferPool(options);
+        db::BufferPool &bufferPool = db.getBufferPool();
+
+        std::string name{"file"};
+        std::remove(name.c_str());
+        db::TupleDesc td;
+        db.add(std::make_unique<db::DbFile>(name, td));
+        for (size_t i = 0; i < num_pages; i++) {
+            db::Page &page = bufferPool.getPage({name, i});
+            page.fill(static_cast<uint8_t>(i));
+            bufferPool.markDirty({name, i});
+        }
+        bufferPool.flushFile(name);
+        EXPECT_EQ(db.get(name).getWrites().size(), num_pages);
+        for (size_t i = 0; i < num_pages; i++) {
+            EXPECT_FALSE(bufferPool.isDirty({name, i}));
+        }
+
+        // reopen the file so that the pages are read back through read-ahead
+        db.remove(name);
+        db.configureBufferPool(options);
+        db::BufferPool &reopened = db.getBufferPool();
+        db.add(std::make_unique<db::DbFile>(name, td));
+        for (size_t i = 0; i < num_pages; i++) {
+            db::Page &page = reopened.getPage({name, i});
+            EXPECT_EQ(page[0], static_cast<uint8_t>(i));
+            EXPECT_EQ(page[db::DEFAULT_PAGE_SIZE - 1], static_cast<uint8_t>(i));
+        }
+        EXPECT_EQ(reopened.getStats().hits + reopened.getStats().misses, num_pages);
+        db.remove(name);
+    }
+}
+
+TEST(IoBackendTest, failedWrite) {
+    // with a file size limit, writes past it fail with EFBIG (instead of raising SIGXFSZ) and writes across it are short
+    struct rlimit limit{};
+    ASSERT_EQ(getrlimit(RLIMIT_FSIZE, &limit), 0);
+    struct sigaction ignore{}, old{};
+    ignore.sa_handler = SIG_IGN;
+    sigaction(SIGXFSZ, &ignore, &old);
+
+    constexpr size_t num_pages = 4;
+    db::Database &db = db::getDatabase();
+    for (db::io_backend_t backend: {db::io_backend_t::SYNC, db::io_backend_t::IO_URING}) {
+        db::BufferPoolOptions options;
+        options.num_pages = 16;
+        options.io_backend = backend;
+        db.configureBufferPool(options);
+        db::BufferPool &bufferPool = db.getBufferPool();
+
+        std::string name{"file"};
+        std::remove(name.c_str());
+        db::TupleDesc td;
+        db.add(std::make_unique<db::DbFile>(name, td));
+        for (size_t i = 0; i < num_pages; i++) {
+            bufferPool.getPage({name, i}).fill(static_cast<uint8_t>(i + 1));
+            bufferPool.markDirty({name, i});
+        }
+        struct rlimit small = limit;
+        small.rlim_cur = 2 * db::DEFAULT_PAGE_SIZE;
+        ASSERT_EQ(setrlimit(RLIMIT_FSIZE, &small), 0);
+        // the batch of 4 pages is written short: none of its pages is clean
+        EXPECT_THROW(bufferPool.flushFile(name), std::runtime_error);
+        // a single page past the limit fails
+        EXPECT_THROW(bufferPool.flushPage({name, num_pages - 1}), std::runtime_error);
+        ASSERT_EQ(setrlimit(RLIMIT_FSIZE, &limit), 0);
+        for (size_t i = 0; i < num_pages; i++) {
+            EXPECT_TRUE(bufferPool.isDirty({name, i}));
+        }
+
+        // the pages are written once the writes succeed again
+        bufferPool.flushFile(name);
+        for (size_t i = 0; i < num_pages; i++) {
+            EXPECT_FALSE(bufferPool.isDirty({name, i}));
+        }
+        db.remove(name);
+    }
+    sigaction(SIGXFSZ, &old, nullptr);
+}
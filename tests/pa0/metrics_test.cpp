@@ -0,0 +1,49 @@
+#include <gtest/gtest.h>
+
+#include <db/Metrics.hpp>
+
+TEST(MetricsTest, traceRing) {
+    db::TraceRing ring(4);
+    for (size_t i = 0; i < 10; i++) {
+        ring.push(i);
+    }
+    EXPECT_EQ(ring.size(), 10);
+    EXPECT_EQ(ring.capacity(), 4);
+    EXPECT_EQ(ring[6], 6);
+    EXPECT_EQ(ring[9], 9);
+    EXPECT_THROW(ring[5], std::out_of_range);
+    EXPECT_THROW(ring[10], std::out_of_range);
+    EXPECT_EQ(ring.retained(), (std::vector<size_t>{6, 7, 8, 9}));
+
+    ring.clear();
+    EXPECT_EQ(ring.size(), 0);
+    EXPECT_TRUE(ring.retained().empty());
+
+    // a ring without capacity only counts
+    ring.setCapacity(0);
+    ring.push(1);
+    EXPECT_EQ(ring.size(), 1);
+    EXPECT_THROW(ring[0], std::out_of_range);
+}
+
+TEST(MetricsTest, latencyHistogram) {
+    db::AtomicLatencyHistogram atomic;
+    for (int64_t ns = 1; ns <= 100; ns++) {
+        atomic.record(std::chrono::nanoseconds(ns * 1000));
+    }
+    db::LatencyHistogram histogram = atomic.snapshot();
+    EXPECT_EQ(histogram.count, 100);
+    EXPECT_DOUBLE_EQ(histogram.mean(), 50'500);
+    // the bounds are the next power of two
+    EXPECT_EQ(histogram.percentile(50), 65'536);
+    EXPECT_EQ(histogram.percentile(1), 1024);
+    EXPECT_EQ(histogram.percentile(100), 131'072);
+
+    histogram += histogram;
+    EXPECT_EQ(histogram.count, 200);
+    EXPECT_EQ(histogram.percentile(50), 65'536);
+
+    atomic.reset();
+    EXPECT_EQ(atomic.snapshot().count, 0);
+    EXPECT_EQ(atomic.snapshot().percentile(50), 0);
+}
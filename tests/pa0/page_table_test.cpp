@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+
+#include <db/PageTable.hpp>
+#include <random>
+#include <thread>
+#include <unordered_map>
+
+TEST(PageTableTest, insertFindErase) {
+    constexpr size_t max_entries = 64;
+    db::PageTable table(max_entries);
+    std::unordered_map<uint64_t, size_t> expected;
+    std::mt19937 gen(42);
+    // random inserts and erases keep the table full enough to create long clusters that wrap around
+    for (size_t round = 0; round < 10'000; round++) {
+        db::PageId pid{static_cast<db::file_id_t>(gen() % 4), gen() % 100};
+        if (expected.contains(pid.key())) {
+            EXPECT_EQ(table.find(pid), expected[pid.key()]);
+            EXPECT_TRUE(table.erase(pid));
+            expected.erase(pid.key());
+        } else if (expected.size() < max_entries) {
+            table.insert(pid, round);
+            expected[pid.key()] = round;
+        }
+        EXPECT_EQ(table.size(), expected.size());
+    }
+    for (uint32_t file = 0; file < 4; file++) {
+        for (size_t page = 0; page < 100; page++) {
+            db::PageId pid{file, page};
+            auto it = expected.find(pid.key());
+            EXPECT_EQ(table.find(pid), it == expected.end() ? db::PageTable::NOT_FOUND : it->second);
+        }
+    }
+    EXPECT_FALSE(table.erase({9, 0}));
+    EXPECT_THROW(table.at({9, 0}), std::out_of_range);
+}
+
+TEST(PageTableTest, full) {
+    db::PageTable table(4);
+    for (size_t i = 0; i < 4; i++) {
+        table.insert({0, i}, i);
+    }
+    EXPECT_THROW(table.insert({0, 4}, 4), std::length_error);
+}
+
+TEST(PageTableTest, concurrentReaders) {
+    constexpr size_t num_pages = 32;
+    db::PageTable table(num_pages);
+    // the even pages stay in the table while a writer keeps inserting and erasing the odd ones
+    for (size_t i = 0; i < num_pages; i += 2) {
+        table.insert({1, i}, i);
+    }
+    std::atomic<bool> done{false};
+    std::thread writer([&] {
+        for (size_t round = 0; round < 20'000; round++) {
+            for (size_t i = 1; i < num_pages; i += 2) {
+                table.insert({1, i}, i);
+            }
+            for (size_t i = 1; i < num_pages; i += 2) {
+                table.erase({1, i});
+            }
+        }
+        done = true;
+    });
+    std::vector<std::thread> readers;
+    for (size_t t = 0; t < 2; t++) {
+        readers.emplace_back([&] {
+            while (!done) {
+                for (size_t i = 0; i < num_pages; i++) {
+                    size_t pos = table.find({1, i});
+                    if (i % 2 == 0) {
+                        ASSERT_EQ(pos, i);
+                    } else {
+                        ASSERT_TRUE(pos == i || pos == db::PageTable::NOT_FOUND);
+                    }
+                }
+            }
+        });
+    }
+    writer.join();
+    for (std::thread &reader: readers) {
+        reader.join();
+    }
+}
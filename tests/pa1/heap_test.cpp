@@ -1,7 +1,11 @@
 #include <db/Database.hpp>
 #include <db/HeapPage.hpp>
 #include <db/HeapFile.hpp>
+#include <db/SlottedPage.hpp>
+#include <algorithm>
+#include <fstream>
 #include <gtest/gtest.h>
+#include <sys/stat.h>
 
 TEST(HeapPageTest, EmptyPage) {
   db::Page page{};
@@ -35,6 +39,72 @@ TEST(HeapPageTest, FullHeader) {
   EXPECT_EQ(count, capacity);
 }
 
+TEST(HeapPageTest, SparseSlots) {
+  // small tuples: hundreds of slots, and a capacity that is not a multiple of 8 or 64
+  db::TupleDesc td({db::type_t::INT, db::type_t::DOUBLE}, {"id", "price"});
+  db::Page page{};
+  db::HeapPage hp(page, td);
+  constexpr size_t capacity = db::DEFAULT_PAGE_SIZE * 8 / (12 * 8 + 1);
+  ASSERT_EQ(hp.end(), capacity);
+  for (size_t i = 0; i < capacity; i++) {
+    ASSERT_TRUE(hp.insertTuple({{static_cast<int>(i), 0.5}}));
+  }
+  EXPECT_FALSE(hp.insertTuple({{0, 0.5}}));
+
+  // keep a few slots around the byte and word boundaries
+  std::vector<size_t> kept{7, 8, 63, 64, 65, 200, capacity - 1};
+  for (size_t slot = 0; slot < capacity; slot++) {
+    if (std::find(kept.begin(), kept.end(), slot) == kept.end()) {
+      hp.deleteTuple(slot);
+    }
+  }
+  std::vector<size_t> scanned;
+  for (size_t slot = hp.begin(); slot != hp.end(); hp.next(slot)) {
+    scanned.push_back(slot);
+  }
+  EXPECT_EQ(scanned, kept);
+
+  // inserts fill the free slots in order
+  for (size_t slot = 0; slot < 70; slot++) {
+    ASSERT_TRUE(hp.insertTuple({{-1, 0.5}}));
+  }
+  EXPECT_EQ(std::get<int>(hp.getTuple(7).get_field(0)), 7);
+  EXPECT_EQ(std::get<int>(hp.getTuple(66).get_field(0)), -1);
+  EXPECT_EQ(std::get<int>(hp.getTuple(74).get_field(0)), -1);
+  EXPECT_TRUE(hp.empty(75));
+}
+
+TEST(HeapPageTest, WideTuples) {
+  // wide tuples: fewer than 8 slots, so the header is a single byte
+  db::TupleDesc td(std::vector<db::type_t>(10, db::type_t::CHAR),
+                   {"c0", "c1", "c2", "c3", "c4", "c5", "c6", "c7", "c8", "c9"});
+  constexpr size_t capacity = db::DEFAULT_PAGE_SIZE * 8 / (10 * db::CHAR_SIZE * 8 + 1);
+  static_assert(capacity < 8);
+  db::Page page{};
+  // the bytes between the header and the data are not slots
+  std::fill(page.begin() + 1, page.end(), 0xff);
+  db::HeapPage hp(page, td);
+  ASSERT_EQ(hp.end(), capacity);
+  EXPECT_EQ(hp.begin(), hp.end());
+  db::Tuple t(std::vector<db::field_t>(10, std::string("wide")));
+  for (size_t i = 0; i < capacity; i++) {
+    ASSERT_TRUE(hp.insertTuple(t));
+  }
+  EXPECT_FALSE(hp.insertTuple(t));
+  hp.deleteTuple(capacity - 1);
+  hp.deleteTuple(1);
+  std::vector<size_t> scanned;
+  for (size_t slot = hp.begin(); slot != hp.end(); hp.next(slot)) {
+    scanned.push_back(slot);
+  }
+  EXPECT_EQ(scanned.size(), capacity - 2);
+  EXPECT_EQ(scanned.front(), 0);
+  EXPECT_EQ(scanned.back(), capacity - 2);
+  ASSERT_TRUE(hp.insertTuple(t));
+  EXPECT_TRUE(hp.empty(capacity - 1));
+  EXPECT_FALSE(hp.empty(1));
+}
+
 TEST(HeapPageTest, CountTuples) {
   db::TupleDesc td({db::type_t::INT, db::type_t::CHAR, db::type_t::DOUBLE}, {"id", "name", "price"});
   db::Page page{0xff, 0b00111101, 0x00, 0b01110000, 0xff, 0xff, 0b11111000}; // 8 + 5 + 0 + 3 + 8 + 8 + 5
@@ -200,3 +270,496 @@ TEST(HeapFileTest, EmptyPage) {
     i++;
   }
 }
+
+TEST(HeapFileTest, ScanRing) {
+  std::vector<db::type_t> types{db::type_t::INT, db::type_t::CHAR, db::type_t::DOUBLE};
+  std::vector<std::string> names{"id", "name", "price"};
+  db::TupleDesc td(types, names);
+
+  const char *name = "heapfile";
+  std::remove(name);
+  db::getDatabase().add(std::make_unique<db::HeapFile>(name, td));
+  auto &file = db::getDatabase().get(name);
+  db::BufferPool &bufferPool = db::getDatabase().getBufferPool();
+  constexpr size_t capacity = 53;
+  constexpr size_t num_pages = 2 * db::DEFAULT_NUM_PAGES;
+  for (size_t i = 0; i < capacity * num_pages; ++i) {
+    file.insertTuple({{static_cast<int>(i), "Hello", 3.14}});
+  }
+  ASSERT_EQ(file.getNumPages(), num_pages);
+
+  // a scan of a file larger than the pool only evicts the pages needed to fill its ring: the pages it brings in
+  // afterwards replace each other
+  bufferPool.resetStats();
+  int i = 0;
+  for (const auto &t : file) {
+    EXPECT_EQ(std::get<int>(t.get_field(0)), i);
+    i++;
+  }
+  EXPECT_EQ(i, capacity * num_pages);
+  db::BufferPoolStats stats = bufferPool.getStats();
+  EXPECT_EQ(stats.evictions, db::SCAN_RING_PAGES);
+  EXPECT_EQ(stats.misses, num_pages - (db::DEFAULT_NUM_PAGES - db::SCAN_RING_PAGES));
+  EXPECT_EQ(stats.recycled, stats.misses - stats.evictions);
+  EXPECT_TRUE(bufferPool.contains({name, num_pages - 1}));
+}
+
+TEST(HeapFileTest, Mapped) {
+  std::vector<db::type_t> types{db::type_t::INT, db::type_t::CHAR, db::type_t::DOUBLE};
+  std::vector<std::string> names{"id", "name", "price"};
+  db::TupleDesc td(types, names);
+
+  const char *name = "heapfile";
+  std::remove(name);
+  db::Database &db = db::getDatabase();
+  db.add(std::make_unique<db::HeapFile>(name, td));
+  constexpr size_t capacity = 53;
+  constexpr size_t num_tuples = 3 * capacity + 1;
+  for (size_t i = 0; i < num_tuples; ++i) {
+    db.get(name).insertTuple({{static_cast<int>(i), "Hello", 3.14}});
+  }
+  db.remove(name);
+
+  // the mapped file is scanned without going through the buffer pool
+  db::DbFileOptions options;
+  options.mmap = true;
+  options.access = db::access_t::SEQUENTIAL;
+  db.add(std::make_unique<db::HeapFile>(name, td, options));
+  auto &file = db.get(name);
+  ASSERT_TRUE(file.isMapped());
+  db::BufferPool &bufferPool = db.getBufferPool();
+  bufferPool.resetStats();
+  int i = 0;
+  for (const auto &t : file) {
+    EXPECT_EQ(std::get<int>(t.get_field(0)), i);
+    EXPECT_EQ(std::get<std::string>(t.get_field(1)), "Hello");
+    i++;
+  }
+  EXPECT_EQ(i, num_tuples);
+  EXPECT_EQ(bufferPool.getStats().misses, 0);
+  EXPECT_EQ(bufferPool.getStats().hits, 0);
+  file.advise(db::access_t::RANDOM);
+  EXPECT_EQ(std::get<int>(file.getTuple({file, 2, 5}).get_field(0)), 2 * capacity + 5);
+
+  EXPECT_THROW(file.insertTuple({{0, "Hello", 3.14}}), std::logic_error);
+  EXPECT_THROW(file.deleteTuple(file.begin()), std::logic_error);
+  EXPECT_THROW(file.writePage(db::Page{}, 0), std::logic_error);
+  db.remove(name);
+
+  // a mapped file must exist
+  std::remove(name);
+  EXPECT_THROW(db::HeapFile(name, td, options), std::runtime_error);
+}
+
+TEST(HeapFileTest, Preallocate) {
+  std::vector<db::type_t> types{db::type_t::INT, db::type_t::CHAR, db::type_t::DOUBLE};
+  std::vector<std::string> names{"id", "name", "price"};
+  db::TupleDesc td(types, names);
+
+  const char *name = "heapfile";
+  std::remove(name);
+  db::DbFileOptions options;
+  options.extent_pages = 8;
+  db::getDatabase().add(std::make_unique<db::HeapFile>(name, td, options));
+  auto &file = db::getDatabase().get(name);
+  constexpr size_t capacity = 53;
+  for (size_t i = 0; i < capacity * 9; ++i) {
+    file.insertTuple({{static_cast<int>(i), "Hello", 3.14}});
+  }
+
+  // the file grows one extent at a time, without changing its size on disk before the pages are written
+  EXPECT_EQ(file.getNumPages(), 9);
+  EXPECT_EQ(file.getAllocatedPages(), 16);
+  struct stat st{};
+  ASSERT_EQ(stat(name, &st), 0);
+  EXPECT_EQ(st.st_size, 0);
+
+  // closing the file releases the space reserved past its end
+  db::getDatabase().remove(name);
+  ASSERT_EQ(stat(name, &st), 0);
+  EXPECT_EQ(st.st_size, 9 * db::DEFAULT_PAGE_SIZE);
+  EXPECT_LE(st.st_blocks * 512, 9 * db::DEFAULT_PAGE_SIZE);
+  EXPECT_EQ(db::HeapFile(name, td, options).getAllocatedPages(), 9);
+}
+
+TEST(HeapFileTest, Compressed) {
+  std::vector<db::type_t> types{db::type_t::INT, db::type_t::CHAR, db::type_t::DOUBLE};
+  std::vector<std::string> names{"id", "name", "price"};
+  db::TupleDesc td(types, names);
+
+  const char *name = "heapfile";
+  std::string map = std::string(name) + ".map";
+  std::remove(name);
+  std::remove(map.c_str());
+  db::DbFileOptions options;
+  options.compression = db::compression_t::LZ;
+  db::Database &db = db::getDatabase();
+  db.add(std::make_unique<db::HeapFile>(name, td, options));
+  constexpr size_t capacity = 53;
+  constexpr size_t num_pages = 2 * db::DEFAULT_NUM_PAGES;
+  for (size_t i = 0; i < capacity * num_pages; ++i) {
+    db.get(name).insertTuple({{static_cast<int>(i), "Hello", 3.14}});
+  }
+  db.remove(name);
+
+  // the pages are packed: the short strings are mostly padding
+  struct stat st{};
+  ASSERT_EQ(stat(name, &st), 0);
+  EXPECT_LT(st.st_size, num_pages * db::DEFAULT_PAGE_SIZE / 3);
+
+  db.add(std::make_unique<db::HeapFile>(name, td, options));
+  auto &file = db.get(name);
+  EXPECT_TRUE(file.isCompressed());
+  EXPECT_EQ(file.getNumPages(), num_pages);
+  file.resetIoStats();
+  int i = 0;
+  for (const auto &t : file) {
+    EXPECT_EQ(std::get<int>(t.get_field(0)), i);
+    EXPECT_EQ(std::get<std::string>(t.get_field(1)), "Hello");
+    i++;
+  }
+  EXPECT_EQ(i, capacity * num_pages);
+  // the pages that are not still in the buffer pool are read compressed
+  db::IoStats io = file.getIoStats();
+  EXPECT_GT(io.reads, 0);
+  EXPECT_LT(io.bytes_read, io.reads * db::DEFAULT_PAGE_SIZE / 3);
+
+  // updated pages are written back in place or moved
+  for (auto it = file.begin(); it != file.end(); ++it) {
+    if (std::get<int>((*it).get_field(0)) % 2 == 0) {
+      file.deleteTuple(it);
+    }
+  }
+  db.remove(name);
+  db.add(std::make_unique<db::HeapFile>(name, td, options));
+  i = 1;
+  for (const auto &t : db.get(name)) {
+    EXPECT_EQ(std::get<int>(t.get_field(0)), i);
+    i += 2;
+  }
+  EXPECT_EQ(i, capacity * num_pages + 1);
+  db.remove(name);
+
+  EXPECT_THROW(db::HeapFile(name, td, {.mmap = true, .compression = db::compression_t::LZ}), std::invalid_argument);
+}
+
+TEST(HeapFileTest, FreeSpaceMap) {
+  std::vector<db::type_t> types{db::type_t::INT, db::type_t::CHAR, db::type_t::DOUBLE};
+  std::vector<std::string> names{"id", "name", "price"};
+  db::TupleDesc td(types, names);
+
+  const char *name = "heapfile";
+  std::string fsm = std::string(name) + ".fsm";
+  std::remove(name);
+  std::remove(fsm.c_str());
+  db::Database &db = db::getDatabase();
+  db.add(std::make_unique<db::HeapFile>(name, td));
+  constexpr size_t capacity = 53;
+  for (size_t i = 0; i < capacity * 3; ++i) {
+    db.get(name).insertTuple({{static_cast<int>(i), "Hello", 3.14}});
+  }
+
+  // the slots freed on the first pages are reused before the file grows
+  auto &file = db.get(name);
+  file.deleteTuple({file, 0, 7});
+  file.deleteTuple({file, 1, 3});
+  file.deleteTuple({file, 1, 4});
+  for (int i = 0; i < 3; ++i) {
+    file.insertTuple({{-1, "Reused", 3.14}});
+  }
+  EXPECT_EQ(file.getNumPages(), 3);
+  EXPECT_EQ(std::get<std::string>(file.getTuple({file, 0, 7}).get_field(1)), "Reused");
+  EXPECT_EQ(std::get<std::string>(file.getTuple({file, 1, 4}).get_field(1)), "Reused");
+  file.insertTuple({{-1, "New", 3.14}});
+  EXPECT_EQ(file.getNumPages(), 4);
+
+  // the map is kept with the file
+  file.deleteTuple({file, 2, 0});
+  db.remove(name);
+  db.add(std::make_unique<db::HeapFile>(name, td));
+  db.get(name).insertTuple({{-1, "Reopened", 3.14}});
+  EXPECT_EQ(std::get<std::string>(db.get(name).getTuple({db.get(name), 2, 0}).get_field(1)), "Reopened");
+  db.remove(name);
+
+  // the map is only a hint: a page that it marks wrongly is checked and skipped
+  {
+    // the first word of the bitmap follows the 8-byte header of the map
+    std::fstream out(fsm, std::ios::in | std::ios::out | std::ios::binary);
+    out.seekp(8);
+    std::vector<char> all(8, static_cast<char>(0xff));
+    out.write(all.data(), static_cast<std::streamsize>(all.size()));
+  }
+  db.add(std::make_unique<db::HeapFile>(name, td));
+  db.get(name).insertTuple({{-1, "Last", 3.14}});
+  EXPECT_EQ(db.get(name).getNumPages(), 4);
+  EXPECT_EQ(std::get<std::string>(db.get(name).getTuple({db.get(name), 3, 1}).get_field(1)), "Last");
+  db.remove(name);
+}
+
+TEST(HeapFileTest, InsertTuples) {
+  std::vector<db::type_t> types{db::type_t::INT, db::type_t::CHAR, db::type_t::DOUBLE};
+  std::vector<std::string> names{"id", "name", "price"};
+  db::TupleDesc td(types, names);
+
+  const char *name = "heapfile";
+  std::remove(name);
+  std::remove((std::string(name) + ".fsm").c_str());
+  db::Database &db = db::getDatabase();
+  db.add(std::make_unique<db::HeapFile>(name, td));
+  auto &file = dynamic_cast<db::HeapFile &>(db.get(name));
+  constexpr size_t capacity = 53;
+  std::vector<db::Tuple> tuples;
+  for (size_t i = 0; i < capacity * 2; ++i) {
+    tuples.push_back({{static_cast<int>(i), "Hello", 3.14}});
+  }
+  file.insertTuples(tuples);
+  EXPECT_EQ(file.getNumPages(), 2);
+
+  // a bad tuple is detected before anything is inserted
+  std::vector<db::Tuple> bad{{{0, "Hello", 3.14}}, {{0, 0, 0}}};
+  EXPECT_THROW(file.insertTuples(bad), std::runtime_error);
+
+  // the free slots are filled first, then the file grows a page at a time
+  file.deleteTuple({file, 0, 10});
+  file.deleteTuple({file, 1, 20});
+  tuples.clear();
+  for (size_t i = 0; i < capacity + 2; ++i) {
+    tuples.push_back({{-static_cast<int>(i), "Bulk", 3.14}});
+  }
+  file.insertTuples(tuples);
+  EXPECT_EQ(file.getNumPages(), 3);
+  EXPECT_EQ(std::get<int>(file.getTuple({file, 0, 10}).get_field(0)), 0);
+  EXPECT_EQ(std::get<int>(file.getTuple({file, 1, 20}).get_field(0)), -1);
+  EXPECT_EQ(std::get<int>(file.getTuple({file, 2, capacity - 1}).get_field(0)), -static_cast<int>(capacity + 1));
+
+  // appended pages are written directly: the last page is filled first
+  file.insertTuple({{-1, "Single", 3.14}});
+  ASSERT_EQ(file.getNumPages(), 4);
+  db::BufferPool &bufferPool = db.getBufferPool();
+  file.resetIoStats();
+  bufferPool.resetStats();
+  tuples.clear();
+  for (size_t i = 0; i < capacity * 3 + 1; ++i) {
+    tuples.push_back({{static_cast<int>(i), "Append", 3.14}});
+  }
+  file.appendTuples(tuples);
+  EXPECT_EQ(file.getNumPages(), 7);
+  EXPECT_EQ(file.getIoStats().writes, 3);
+  EXPECT_EQ(bufferPool.getStats().misses, 0);
+  size_t count = 0;
+  for (const auto &t : file) {
+    count++;
+  }
+  EXPECT_EQ(count, capacity * 6 + 2);
+  EXPECT_EQ(std::get<int>(file.getTuple({file, 3, capacity - 1}).get_field(0)), capacity - 2);
+  EXPECT_EQ(std::get<int>(file.getTuple({file, 4, 0}).get_field(0)), capacity - 1);
+  EXPECT_EQ(std::get<int>(file.getTuple({file, 6, 1}).get_field(0)), capacity * 3);
+  db.remove(name);
+}
+
+TEST(SlottedPageTest, InsertDelete) {
+  db::Page page{};
+  db::TupleDesc td({db::type_t::INT, db::type_t::CHAR, db::type_t::DOUBLE}, {"id", "name", "price"});
+  db::SlottedPage sp(page, td);
+  EXPECT_EQ(sp.begin(), sp.end());
+
+  // a short string only takes its length: each tuple uses 4 + 6 + 8 bytes and a 4-byte slot
+  constexpr size_t capacity = (db::DEFAULT_PAGE_SIZE - sizeof(db::SlottedPageHeader)) / 22;
+  for (size_t i = 0; i < capacity; ++i) {
+    EXPECT_TRUE(sp.insertTuple({{static_cast<int>(i), "Hello", 3.14}}));
+  }
+  EXPECT_FALSE(sp.insertTuple({{-1, "Hello", 3.14}}));
+  EXPECT_EQ(sp.end(), capacity);
+
+  // deleting compacts the records: a longer tuple fits in the space of two short ones, in the first empty slot
+  constexpr size_t spare = (db::DEFAULT_PAGE_SIZE - sizeof(db::SlottedPageHeader)) % 22;
+  const std::string longer(10 + spare, 'x');
+  sp.deleteTuple(10);
+  EXPECT_THROW(sp.deleteTuple(10), std::runtime_error);
+  EXPECT_THROW(sp.deleteTuple(capacity), std::runtime_error);
+  EXPECT_FALSE(sp.insertTuple({{-1, longer, 3.14}}));
+  sp.deleteTuple(5);
+  EXPECT_TRUE(sp.insertTuple({{-1, longer, 3.14}}));
+  EXPECT_EQ(std::get<std::string>(sp.getTuple(5).get_field(1)), longer);
+  EXPECT_TRUE(sp.empty(10));
+  for (size_t i = 0; i < capacity; ++i) {
+    if (i != 5 && i != 10) {
+      EXPECT_EQ(std::get<int>(sp.getTuple(i).get_field(0)), static_cast<int>(i));
+    }
+  }
+
+  // trailing empty slots are dropped from the directory
+  size_t slot = capacity - 2;
+  sp.deleteTuple(capacity - 1);
+  EXPECT_EQ(sp.end(), capacity - 1);
+  sp.deleteTuple(capacity - 2);
+  sp.next(slot);
+  EXPECT_EQ(slot, sp.end());
+  size_t count = 0;
+  for (slot = sp.begin(); slot != sp.end(); sp.next(slot)) {
+    count++;
+  }
+  EXPECT_EQ(count, capacity - 3);
+}
+
+TEST(HeapFileTest, Slotted) {
+  std::vector<db::type_t> types{db::type_t::INT, db::type_t::CHAR, db::type_t::DOUBLE};
+  std::vector<std::string> names{"id", "name", "price"};
+  db::TupleDesc td(types, names);
+
+  const char *name = "heapfile";
+  std::remove(name);
+  std::remove((std::string(name) + ".fsm").c_str());
+  db::Database &db = db::getDatabase();
+  db.add(std::make_unique<db::HeapFile>(name, td, db::DbFileOptions{.layout = db::heap_layout_t::SLOTTED}));
+  auto &file = dynamic_cast<db::HeapFile &>(db.get(name));
+
+  // 1000 short tuples fit in 6 pages instead of 19 fixed-width pages
+  constexpr size_t num_tuples = 1000;
+  for (size_t i = 0; i < num_tuples / 2; ++i) {
+    file.insertTuple({{static_cast<int>(i), "Hello", 3.14}});
+  }
+  std::vector<db::Tuple> tuples;
+  for (size_t i = num_tuples / 2; i < num_tuples; ++i) {
+    tuples.push_back({{static_cast<int>(i), "Hello", 3.14}});
+  }
+  file.insertTuples(tuples);
+  EXPECT_EQ(file.getNumPages(), 6);
+  int expected = 0;
+  for (const auto &t : file) {
+    EXPECT_EQ(std::get<int>(t.get_field(0)), expected++);
+  }
+  EXPECT_EQ(expected, num_tuples);
+
+  // the space of a deleted tuple is reused through the free-space map
+  file.deleteTuple({file, 1, 3});
+  file.deleteTuple({file, 1, 4});
+  file.insertTuple({{-1, "Hello, world!", 3.14}});
+  EXPECT_EQ(file.getNumPages(), 6);
+  EXPECT_EQ(std::get<std::string>(file.getTuple({file, 1, 3}).get_field(1)), "Hello, world!");
+  size_t count = 0;
+  for (const auto &t : file) {
+    count++;
+  }
+  EXPECT_EQ(count, num_tuples - 1);
+
+  // the pages are written back and read again in the same format
+  db.remove(name);
+  db.add(std::make_unique<db::HeapFile>(name, td, db::DbFileOptions{.layout = db::heap_layout_t::SLOTTED}));
+  auto &reopened = db.get(name);
+  EXPECT_EQ(std::get<std::string>(reopened.getTuple({reopened, 1, 3}).get_field(1)), "Hello, world!");
+  EXPECT_EQ(std::get<int>(reopened.getTuple({reopened, 5, 0}).get_field(0)), 5 * 185);
+  db.remove(name);
+
+  // the layout is recorded with the file: opening it with another one fails instead of misreading the pages
+  EXPECT_THROW(db::HeapFile(name, td), std::invalid_argument);
+  EXPECT_THROW(db::HeapFile(name, td, db::DbFileOptions{.mmap = true}), std::invalid_argument);
+  db::HeapFile mapped(name, td, db::DbFileOptions{.mmap = true, .layout = db::heap_layout_t::SLOTTED});
+  EXPECT_EQ(std::get<std::string>(mapped.getTuple({mapped, 1, 3}).get_field(1)), "Hello, world!");
+}
+
+TEST(HeapFileTest, Compact) {
+  std::vector<db::type_t> types{db::type_t::INT, db::type_t::CHAR, db::type_t::DOUBLE};
+  std::vector<std::string> names{"id", "name", "price"};
+  db::TupleDesc td(types, names);
+
+  db::Database &db = db::getDatabase();
+  // 530 tuples take 10 fixed-width pages or 3 slotted pages; the 133 left after the purge fit in 3 and 1
+  for (auto [layout, live_pages] : {std::pair{db::heap_layout_t::FIXED, 3}, std::pair{db::heap_layout_t::SLOTTED, 1}}) {
+    const char *name = "heapfile";
+    std::remove(name);
+    std::remove((std::string(name) + ".fsm").c_str());
+    db.add(std::make_unique<db::HeapFile>(name, td, db::DbFileOptions{.layout = layout}));
+    auto &file = dynamic_cast<db::HeapFile &>(db.get(name));
+    constexpr int num_tuples = 530;
+    for (int i = 0; i < num_tuples; ++i) {
+      file.insertTuple({{i, "Hello", 3.14}});
+    }
+    size_t pages = file.getNumPages();
+    for (auto it = file.begin(); it != file.end(); file.next(it)) {
+      if (std::get<int>(file.getTuple(it).get_field(0)) % 4 != 0) {
+        file.deleteTuple(it);
+      }
+    }
+    EXPECT_EQ(file.getNumPages(), pages);
+
+    // a bounded step empties at most the requested number of pages
+    EXPECT_EQ(file.compact(1), 1);
+    EXPECT_EQ(file.getNumPages(), pages - 1);
+    EXPECT_EQ(file.compact(), pages - 1 - live_pages);
+    EXPECT_EQ(file.compact(), 0);
+    EXPECT_EQ(file.getNumPages(), live_pages);
+
+    // every tuple is still there once, and a scan only reads the remaining pages
+    db.getBufferPool().flushFile(name);
+    std::vector<int> ids;
+    for (const auto &t : file) {
+      ids.push_back(std::get<int>(t.get_field(0)));
+    }
+    std::sort(ids.begin(), ids.end());
+    ASSERT_EQ(ids.size(), (num_tuples + 3) / 4);
+    for (size_t i = 0; i < ids.size(); ++i) {
+      EXPECT_EQ(ids[i], 4 * i);
+    }
+    struct stat st{};
+    ASSERT_EQ(stat(name, &st), 0);
+    EXPECT_EQ(st.st_size, live_pages * db::DEFAULT_PAGE_SIZE);
+
+    // the file keeps working after the truncation
+    file.insertTuple({{-1, "After", 3.14}});
+    db.remove(name);
+    db.add(std::make_unique<db::HeapFile>(name, td, db::DbFileOptions{.layout = layout}));
+    size_t count = 0;
+    for (const auto &t : db.get(name)) {
+      count++;
+    }
+    EXPECT_EQ(count, ids.size() + 1);
+    db.remove(name);
+  }
+}
+
+TEST(HeapFileTest, CompactPinned) {
+  std::vector<db::type_t> types{db::type_t::INT, db::type_t::CHAR, db::type_t::DOUBLE};
+  std::vector<std::string> names{"id", "name", "price"};
+  db::TupleDesc td(types, names);
+
+  const char *name = "heapfile";
+  std::remove(name);
+  std::remove((std::string(name) + ".fsm").c_str());
+  db::Database &db = db::getDatabase();
+  db.add(std::make_unique<db::HeapFile>(name, td));
+  auto &file = dynamic_cast<db::HeapFile &>(db.get(name));
+  constexpr size_t capacity = 53;
+  for (size_t i = 0; i < capacity * 4; ++i) {
+    file.insertTuple({{static_cast<int>(i), "Hello", 3.14}});
+  }
+  // the first two pages are emptied: the tuples of the last two move there
+  for (size_t page = 0; page < 2; ++page) {
+    for (size_t slot = 0; slot < capacity; ++slot) {
+      file.deleteTuple({file, page, slot});
+    }
+  }
+
+  // a reader holds the third page: the pages after it are dropped, it stays (empty)
+  db::PageGuard guard = db.getBufferPool().pin({file.getId(), 2});
+  EXPECT_EQ(file.compact(), 1);
+  EXPECT_EQ(file.getNumPages(), 3);
+  std::vector<int> ids;
+  for (const auto &t : file) {
+    ids.push_back(std::get<int>(t.get_field(0)));
+  }
+  std::sort(ids.begin(), ids.end());
+  EXPECT_EQ(ids.size(), capacity * 2);
+  EXPECT_EQ(std::adjacent_find(ids.begin(), ids.end()), ids.end());
+
+  // once it is released, it is dropped too
+  guard.release();
+  EXPECT_EQ(file.compact(), 1);
+  EXPECT_EQ(file.getNumPages(), 2);
+  size_t count = 0;
+  for (const auto &t : file) {
+    count++;
+  }
+  EXPECT_EQ(count, ids.size());
+  db.remove(name);
+}
@@ -105,3 +105,27 @@ TEST(TupleTest, MergeConflict) {
 
   EXPECT_ANY_THROW(db::TupleDesc::merge(td1, td2));  // Non-unique names
 }
+
+TEST(TupleTest, CompactSerialization) {
+  std::vector<db::type_t> types{db::type_t::INT, db::type_t::CHAR, db::type_t::DOUBLE};
+  std::vector<std::string> names{"id", "name", "price"};
+  db::TupleDesc td(types, names);
+
+  db::Tuple t({1, "Hi", 2.5});
+  EXPECT_EQ(td.compact_length(t), db::INT_SIZE + 1 + 2 + db::DOUBLE_SIZE);
+  std::vector<uint8_t> data(td.compact_length(t));
+  td.serialize_compact(data.data(), t);
+  db::Tuple copy = td.deserialize_compact(data.data());
+  EXPECT_EQ(std::get<int>(copy.get_field(0)), 1);
+  EXPECT_EQ(std::get<std::string>(copy.get_field(1)), "Hi");
+  EXPECT_EQ(std::get<double>(copy.get_field(2)), 2.5);
+
+  // like the fixed-width serialization, a CHAR field keeps at most CHAR_SIZE characters
+  db::Tuple empty({0, "", 0.0});
+  EXPECT_EQ(td.compact_length(empty), db::INT_SIZE + 1 + db::DOUBLE_SIZE);
+  db::Tuple longer({0, std::string(db::CHAR_SIZE + 10, 'x'), 0.0});
+  EXPECT_EQ(td.compact_length(longer), db::INT_SIZE + 1 + db::CHAR_SIZE + db::DOUBLE_SIZE);
+  data.resize(td.compact_length(longer));
+  td.serialize_compact(data.data(), longer);
+  EXPECT_EQ(std::get<std::string>(td.deserialize_compact(data.data()).get_field(1)), std::string(db::CHAR_SIZE, 'x'));
+}